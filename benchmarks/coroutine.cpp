@@ -0,0 +1,151 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares a protocol written as State subclasses against the same protocol as coroutine
+ *
+ * The protocol is a sequence of 8 steps, each step waits for a step event and then advances to the
+ * next step. The classic FSM has one state per step and transits on every event, the coroutine
+ * awaits the step events one after another. Requires C++20.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "scriptsizefsm/coroutine.hpp"
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+constexpr std::size_t n_steps {8};
+constexpr std::uint64_t n_events {50000000};
+
+class StepEvent : public scriptsizefsm::Event {};
+
+template<std::size_t S>
+class StepState;
+
+namespace classic {
+
+    class FSM;
+
+    class GenericState : public scriptsizefsm::State<FSM> {
+      public:
+
+        virtual void react(FSM* const fsm, const StepEvent& event) const {};
+    };
+
+    template<std::size_t S>
+    class Step : public GenericState {
+      public:
+
+        void react(FSM* const fsm, const StepEvent& event) const override;
+    };
+
+    class FSM : public scriptsizefsm::FSM<FSM, GenericState> {
+        friend scriptsizefsm::FSM<FSM, GenericState>;
+
+      public:
+
+        std::uint64_t steps {0};
+
+      protected:
+
+        FSM(const GenericState* const init_state)
+          : scriptsizefsm::FSM<FSM, GenericState>(init_state) {};
+    };
+
+    template<std::size_t S>
+    void Step<S>::react(FSM* const fsm, const StepEvent& event) const
+    {
+        ++fsm->steps;
+        this->template transit<Step<(S + 1) % n_steps>>(fsm);
+    };
+
+}  // namespace classic
+
+namespace coroutine {
+
+    template<std::size_t... S>
+    scriptsizefsm::StateList<StepState<S>...> state_list(std::index_sequence<S...>);
+
+    using States = decltype(state_list(std::make_index_sequence<n_steps> {}));
+
+    class FSM : public scriptsizefsm::CoroutineFSM<FSM, States, StepState<0>> {
+        friend scriptsizefsm::CoroutineFSM<FSM, States, StepState<0>>;
+
+      public:
+
+        std::uint64_t steps {0};
+
+      protected:
+
+        FSM(scriptsizefsm::FramePool* const pool)
+          : scriptsizefsm::CoroutineFSM<FSM, States, StepState<0>>(pool) {};
+
+        template<std::size_t S>
+        void step()
+        {
+            ++steps;
+            set_state<StepState<S % n_steps>>();
+        }
+
+        scriptsizefsm::Coroutine protocol()
+        {
+            while(true) {
+                co_await next<StepEvent>();
+                step<1>();
+                co_await next<StepEvent>();
+                step<2>();
+                co_await next<StepEvent>();
+                step<3>();
+                co_await next<StepEvent>();
+                step<4>();
+                co_await next<StepEvent>();
+                step<5>();
+                co_await next<StepEvent>();
+                step<6>();
+                co_await next<StepEvent>();
+                step<7>();
+                co_await next<StepEvent>();
+                step<8>();
+            }
+        };
+    };
+
+}  // namespace coroutine
+
+template<class T_FSM>
+double bench(T_FSM& fsm)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::uint64_t event = 0; event < n_events; ++event) {
+        fsm.react(StepEvent());
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_events);
+}
+
+int main()
+{
+    auto classic_fsm = scriptsizefsm::start<classic::FSM, classic::Step<0>>();
+    const double classic_ns = bench(classic_fsm);
+
+    scriptsizefsm::FramePool pool {};
+    auto coroutine_fsm = scriptsizefsm::start<coroutine::FSM, StepState<0>>(&pool);
+    const double coroutine_ns = bench(coroutine_fsm);
+
+    std::cout << "steps: " << n_steps << ", events: " << n_events << "\n"
+              << "State subclasses: " << classic_ns << " ns/event\n"
+              << "coroutine:        " << coroutine_ns << " ns/event\n"
+              << "speedup: " << classic_ns / coroutine_ns << std::endl;
+
+    return classic_fsm.steps == coroutine_fsm.steps &&
+                   coroutine_fsm.state_id() == classic_fsm.steps % n_steps
+               ? 0
+               : 1;
+}
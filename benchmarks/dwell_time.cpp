@@ -0,0 +1,131 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief measures the cost of recording dwell times with scriptsizefsm::DwellTracer
+ *
+ * The same FSM toggles between two states without tracing, with the dwell time of every state
+ * recorded into histograms and with the default sampling of about one in eight dwell times.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+
+#include "scriptsizefsm/histogram.hpp"
+
+constexpr std::uint64_t n_transitions {50000000};
+
+class ToggleEvent : public scriptsizefsm::Event {};
+
+template<std::uint32_t N_Sampling>
+class FSM;
+
+template<std::uint32_t N_Sampling>
+class GenericState : public scriptsizefsm::State<FSM<N_Sampling>> {
+  public:
+
+    virtual void react(FSM<N_Sampling>* const fsm, const ToggleEvent& event) const {};
+};
+
+template<std::uint32_t N_Sampling>
+class OnState : public GenericState<N_Sampling> {
+  public:
+
+    void react(FSM<N_Sampling>* const fsm, const ToggleEvent& event) const override;
+};
+
+template<std::uint32_t N_Sampling>
+class OffState : public GenericState<N_Sampling> {
+  public:
+
+    void react(FSM<N_Sampling>* const fsm, const ToggleEvent& event) const override;
+};
+
+template<std::uint32_t N_Sampling>
+using States = scriptsizefsm::StateList<OnState<N_Sampling>, OffState<N_Sampling>>;
+
+// zero stands for no tracing
+template<std::uint32_t N_Sampling>
+using Tracer = std::conditional_t<
+    (N_Sampling > 0),
+    scriptsizefsm::DwellTracer<States<N_Sampling>, (N_Sampling > 0 ? N_Sampling : 1)>,
+    scriptsizefsm::NoTracer>;
+
+template<std::uint32_t N_Sampling>
+using FSMBase = scriptsizefsm::CompactFSM<
+    FSM<N_Sampling>,
+    GenericState<N_Sampling>,
+    States<N_Sampling>,
+    OnState<N_Sampling>,
+    Tracer<N_Sampling>>;
+
+template<std::uint32_t N_Sampling>
+class FSM : public FSMBase<N_Sampling> {
+    friend FSMBase<N_Sampling>;
+};
+
+template<std::uint32_t N_Sampling>
+void OnState<N_Sampling>::react(FSM<N_Sampling>* const fsm, const ToggleEvent& event) const
+{
+    this->template transit<OffState<N_Sampling>>(fsm);
+};
+
+template<std::uint32_t N_Sampling>
+void OffState<N_Sampling>::react(FSM<N_Sampling>* const fsm, const ToggleEvent& event) const
+{
+    this->template transit<OnState<N_Sampling>>(fsm);
+};
+
+template<class T_FSM>
+double bench(T_FSM& fsm)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::uint64_t transition = 0; transition < n_transitions; ++transition) {
+        fsm.react(ToggleEvent());
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_transitions);
+}
+
+int main()
+{
+    auto untraced = scriptsizefsm::start<FSM<0>, OnState<0>>();
+    const double untraced_ns = bench(untraced);
+
+    auto histograms = std::make_unique<scriptsizefsm::DwellHistograms<States<1>>>();
+    auto traced = scriptsizefsm::start<FSM<1>, OnState<1>>();
+    traced.tracer().attach(*histograms);
+    const double traced_ns = bench(traced);
+
+    auto sampled_histograms = std::make_unique<scriptsizefsm::DwellHistograms<States<8>>>();
+    auto sampled = scriptsizefsm::start<FSM<8>, OnState<8>>();
+    sampled.tracer().attach(*sampled_histograms);
+    const double sampled_ns = bench(sampled);
+
+    const auto& histogram = histograms->get<OnState<1>>();
+    const double ns_per_tick = 1e9 / scriptsizefsm::timestamp_frequency();
+    std::cout << "transitions: " << n_transitions << "\n"
+              << "untraced:    " << untraced_ns << " ns/transition\n"
+              << "dwell times: " << traced_ns << " ns/transition\n"
+              << "overhead:    " << traced_ns - untraced_ns << " ns/transition\n"
+              << "sampled 1/8: " << sampled_ns << " ns/transition\n"
+              << "overhead:    " << sampled_ns - untraced_ns << " ns/transition\n"
+              << "median dwell time: " << static_cast<double>(histogram.quantile(0.5)) * ns_per_tick
+              << " ns" << std::endl;
+
+    // the sampled visits are split evenly between the two states
+    const auto sampled_in = [&sampled_histograms](const auto& state) {
+        using T_State = std::decay_t<decltype(state)>;
+        const auto count = static_cast<double>(sampled_histograms->get<T_State>().count());
+        return count > 0.95 * n_transitions / 16 && count < 1.05 * n_transitions / 16;
+    };
+    const bool complete = histogram.count() == n_transitions / 2 && sampled_in(OnState<8>()) &&
+                          sampled_in(OffState<8>());
+    return complete ? 0 : 1;
+}
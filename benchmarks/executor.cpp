@@ -0,0 +1,125 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares polling all mailboxes against scheduling only FSMs with pending events
+ *
+ * Many FSMs with a mailbox receive events, but only a small fraction of them per round. In the
+ * first run a thread polls the mailboxes of all FSMs, in the second run a `scriptsizefsm::Executor`
+ * only runs the FSMs that have pending events.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/executor.hpp"
+
+constexpr std::size_t n_fsms {10000};
+constexpr std::size_t n_active {10};
+constexpr std::size_t n_rounds {10000};
+
+class TickEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const TickEvent& event) const;
+};
+
+class CountingState : public GenericState {};
+
+class FSM
+  : public scriptsizefsm::FSM<FSM, GenericState>,
+    public scriptsizefsm::Mailbox<FSM, 16, 8> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+
+  public:
+
+    std::uint64_t ticks {0};
+
+  protected:
+
+    FSM(const GenericState* const init_state)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state) {};
+};
+
+void GenericState::react(FSM* const fsm, const TickEvent& event) const
+{
+    ++fsm->ticks;
+};
+
+template<class T_Post, class T_Process>
+double bench(const std::vector<std::size_t>& targets, T_Post&& post, T_Process&& process)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < n_rounds; ++round) {
+        for(std::size_t index = 0; index < n_active; ++index) {
+            post(targets[round * n_active + index]);
+        }
+        process();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_rounds * n_active);
+}
+
+int main()
+{
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<std::size_t> distribution {0, n_fsms - 1};
+    std::vector<std::size_t> targets(n_rounds * n_active);
+    for(auto& target : targets) {
+        target = distribution(generator);
+    }
+
+    // a FSM with a mailbox can not be moved, so each one is allocated on its own
+    std::vector<std::unique_ptr<FSM>> polled {};
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        polled.emplace_back(new FSM(scriptsizefsm::start<FSM, CountingState>()));
+    }
+    const double polled_ns = bench(
+        targets,
+        [&polled](std::size_t id) { polled[id]->post(TickEvent()); },
+        [&polled]() {
+            for(auto& fsm : polled) {
+                fsm->drain();
+            }
+        }
+    );
+
+    scriptsizefsm::ThreadPool pool {std::thread::hardware_concurrency()};
+    scriptsizefsm::Executor<FSM> executor {pool};
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        executor.spawn<CountingState>();
+    }
+    const double executor_ns = bench(
+        targets,
+        [&executor](std::size_t id) { executor.post(id, TickEvent()); },
+        [&executor]() { executor.wait(); }
+    );
+
+    std::uint64_t polled_ticks = 0;
+    std::uint64_t executor_ticks = 0;
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        polled_ticks += polled[id]->ticks;
+        executor_ticks += executor[id].ticks;
+    }
+
+    std::cout << "fsms: " << n_fsms << ", active per round: " << n_active
+              << ", workers: " << pool.size() << "\n"
+              << "polling:  " << polled_ns << " ns/event\n"
+              << "executor: " << executor_ns << " ns/event\n"
+              << "speedup: " << polled_ns / executor_ns << std::endl;
+
+    return polled_ticks == executor_ticks ? 0 : 1;
+}
@@ -0,0 +1,456 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief measures the event throughput of ten million FSMs under realistic event streams
+ *
+ * The FSM is the on-off switch of the extended_switch example with its current, once as `FSM`
+ * and once as `CompactFSM`. Ten million instances are stored in a vector and driven by a uniform,
+ * a Zipf-skewed and a bursty stream of events to random instances, so that cache misses dominate
+ * as they do in production. For each stream, the events per second, the L1 data cache and last
+ * level cache misses per event and the memory per instance are reported, for one thread and for
+ * doubling thread counts up to the hardware concurrency. With several threads, every thread
+ * drives its own contiguous range of instances. The cache misses are counted with
+ * `perf_event_open` and reported as unavailable if it is not permitted or not supported.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define SCRIPTSIZEFSM_HAS_PERF_EVENT
+#endif
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+constexpr std::size_t n_fsms {10000000};
+constexpr std::size_t n_events {2 * n_fsms};
+constexpr std::size_t burst_length {16};
+constexpr double zipf_theta {0.99};
+
+class OnEvent : public scriptsizefsm::Event {
+  public:
+
+    OnEvent(double _current)
+      : current(_current) {};
+
+    double current;
+};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+enum class Mode
+{
+    classic,
+    compact,
+};
+
+template<Mode M>
+class FSM;
+
+template<Mode M>
+class GenericState : public scriptsizefsm::State<FSM<M>> {
+  public:
+
+    virtual void entry(FSM<M>* const fsm) const override {};
+    virtual void react(FSM<M>* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const OffEvent& event) const {};
+};
+
+template<Mode M>
+class OnState : public GenericState<M> {
+  public:
+
+    void react(FSM<M>* const fsm, const OnEvent& event) const override;
+    void react(FSM<M>* const fsm, const OffEvent& event) const override;
+};
+
+template<Mode M>
+class OffState : public GenericState<M> {
+  public:
+
+    void entry(FSM<M>* const fsm) const override;
+    void react(FSM<M>* const fsm, const OnEvent& event) const override;
+};
+
+template<Mode M>
+using States = scriptsizefsm::StateList<OnState<M>, OffState<M>>;
+
+template<Mode M>
+using FSMBase = std::conditional_t<
+    M == Mode::classic,
+    scriptsizefsm::FSM<FSM<M>, GenericState<M>>,
+    scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, OnState<M>>>;
+
+template<Mode M>
+class FSM : public FSMBase<M> {
+    friend FSMBase<M>;
+    friend OnState<M>;
+    friend OffState<M>;
+
+  public:
+
+    inline double getCurrent()
+    {
+        return current_;
+    };
+
+  protected:
+
+    inline void setCurrent(double current)
+    {
+        current_ = current;
+    };
+
+    FSM(const GenericState<M>* const init_state, double current)
+      : FSMBase<M>(init_state),
+        initial_current_(current),
+        current_(current) {};
+
+    FSM(double current)
+      : initial_current_(current),
+        current_(current) {};
+
+    // overrides the virtual resetter of FSM and hides the one of CompactFSM
+    void resetter()
+    {
+        setCurrent(initial_current_);
+    };
+
+  private:
+
+    const double initial_current_;
+    double current_;
+};
+
+template<Mode M>
+void OnState<M>::react(FSM<M>* const fsm, const OnEvent& event) const
+{
+    fsm->setCurrent(event.current);
+};
+
+template<Mode M>
+void OnState<M>::react(FSM<M>* const fsm, const OffEvent& event) const
+{
+    this->template transit<OffState<M>>(fsm);
+};
+
+template<Mode M>
+void OffState<M>::entry(FSM<M>* const fsm) const
+{
+    fsm->setCurrent(0.);
+};
+
+template<Mode M>
+void OffState<M>::react(FSM<M>* const fsm, const OnEvent& event) const
+{
+    fsm->setCurrent(event.current);
+    this->template transit<OnState<M>>(fsm);
+};
+
+/**
+ * @brief event of a stream, addressed to an instance
+ */
+struct Work {
+    std::uint32_t instance;
+    bool on;
+};
+
+enum class Stream
+{
+    uniform,
+    zipf,
+    bursty,
+};
+
+const char* stream_name(Stream stream)
+{
+    switch(stream) {
+    case Stream::uniform:
+        return "uniform";
+    case Stream::zipf:
+        return "zipf";
+    case Stream::bursty:
+        return "bursty";
+    }
+    return "";
+}
+
+/**
+ * @brief Zipf distributed ranks in [0, n) after Gray et al., "Quickly Generating Billion-Record
+ * Synthetic Databases"
+ */
+class Zipf {
+  public:
+
+    Zipf(std::size_t n, double theta)
+      : n_(static_cast<double>(n)),
+        theta_(theta),
+        alpha_(1. / (1. - theta))
+    {
+        double zeta_n = 0.;
+        for(std::size_t rank = 1; rank <= n; ++rank) {
+            zeta_n += 1. / std::pow(static_cast<double>(rank), theta);
+        }
+        zeta_n_ = zeta_n;
+        const double zeta_2 = 1. + 1. / std::pow(2., theta);
+        eta_ = (1. - std::pow(2. / n_, 1. - theta)) / (1. - zeta_2 / zeta_n);
+    }
+
+    template<class T_Generator>
+    std::size_t operator()(T_Generator& generator)
+    {
+        const double u = std::uniform_real_distribution<double> {0., 1.}(generator);
+        const double uz = u * zeta_n_;
+        if(uz < 1.) {
+            return 0;
+        }
+        if(uz < 1. + std::pow(0.5, theta_)) {
+            return 1;
+        }
+        const auto rank = static_cast<std::size_t>(n_ * std::pow(eta_ * u - eta_ + 1., alpha_));
+        return std::min(rank, static_cast<std::size_t>(n_) - 1);
+    }
+
+  private:
+
+    double n_;
+    double theta_;
+    double alpha_;
+    double zeta_n_ {0.};
+    double eta_ {0.};
+};
+
+/**
+ * @brief stream of events to the instances in [begin, begin + size)
+ *
+ * The Zipf ranks are scattered over the range, so that the hot instances do not share cache
+ * lines.
+ */
+std::vector<Work>
+    make_stream(Stream stream, std::size_t begin, std::size_t size, std::size_t length)
+{
+    std::mt19937_64 generator {begin + 1};
+    std::uniform_int_distribution<std::size_t> uniform {0, size - 1};
+    std::bernoulli_distribution on {0.5};
+    std::vector<Work> work {};
+    work.reserve(length);
+    const auto add = [&](std::size_t instance) {
+        work.push_back(Work {static_cast<std::uint32_t>(begin + instance), on(generator)});
+    };
+
+    switch(stream) {
+    case Stream::uniform:
+        while(work.size() < length) {
+            add(uniform(generator));
+        }
+        break;
+    case Stream::zipf: {
+        Zipf zipf {size, zipf_theta};
+        while(work.size() < length) {
+            add(static_cast<std::size_t>(zipf(generator) * 2654435761ULL % size));
+        }
+        break;
+    }
+    case Stream::bursty:
+        while(work.size() < length) {
+            const std::size_t instance = uniform(generator);
+            for(std::size_t event = 0; event < burst_length && work.size() < length; ++event) {
+                add(instance);
+            }
+        }
+        break;
+    }
+    return work;
+}
+
+/**
+ * @brief counts L1 data cache and last level cache read misses of the process and its threads
+ */
+class CacheCounters {
+  public:
+
+    CacheCounters()
+    {
+#ifdef SCRIPTSIZEFSM_HAS_PERF_EVENT
+        l1_ = open(PERF_COUNT_HW_CACHE_L1D);
+        llc_ = open(PERF_COUNT_HW_CACHE_LL);
+#endif
+    };
+
+    ~CacheCounters()
+    {
+#ifdef SCRIPTSIZEFSM_HAS_PERF_EVENT
+        for(const int counter : {l1_, llc_}) {
+            if(counter >= 0) {
+                close(counter);
+            }
+        }
+#endif
+    };
+
+    CacheCounters(const CacheCounters&) = delete;
+    CacheCounters& operator=(const CacheCounters&) = delete;
+
+    inline bool available() const
+    {
+        return l1_ >= 0 && llc_ >= 0;
+    };
+
+    void start()
+    {
+#ifdef SCRIPTSIZEFSM_HAS_PERF_EVENT
+        for(const int counter : {l1_, llc_}) {
+            ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    };
+
+    /**
+     * @brief stops counting, to be called after all threads are joined
+     * @return misses of the L1 data cache and of the last level cache
+     */
+    std::array<std::uint64_t, 2> stop()
+    {
+        std::array<std::uint64_t, 2> misses {};
+#ifdef SCRIPTSIZEFSM_HAS_PERF_EVENT
+        const std::array<int, 2> counters {l1_, llc_};
+        for(std::size_t index = 0; index < counters.size(); ++index) {
+            ioctl(counters[index], PERF_EVENT_IOC_DISABLE, 0);
+            if(read(counters[index], &misses[index], sizeof(std::uint64_t)) !=
+               sizeof(std::uint64_t)) {
+                misses[index] = 0;
+            }
+        }
+#endif
+        return misses;
+    };
+
+  private:
+
+#ifdef SCRIPTSIZEFSM_HAS_PERF_EVENT
+    static int open(std::uint64_t cache)
+    {
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    };
+#endif
+
+    int l1_ {-1};
+    int llc_ {-1};
+};
+
+template<Mode M>
+void drive(std::vector<FSM<M>>& fleet, const std::vector<Work>& work)
+{
+    for(const Work& item : work) {
+        auto& fsm = fleet[item.instance];
+        if(item.on) {
+            fsm.react(OnEvent(static_cast<double>(item.instance & 0xFU)));
+        } else {
+            fsm.react(OffEvent());
+        }
+    }
+}
+
+template<Mode M>
+void bench(
+    const char* name,
+    std::vector<FSM<M>>& fleet,
+    const std::vector<std::vector<Work>>& streams,
+    Stream stream,
+    CacheCounters& counters
+)
+{
+    std::vector<std::thread> threads {};
+    counters.start();
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::size_t thread = 1; thread < streams.size(); ++thread) {
+        threads.emplace_back(drive<M>, std::ref(fleet), std::cref(streams[thread]));
+    }
+    drive<M>(fleet, streams[0]);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto misses = counters.stop();
+
+    const std::chrono::duration<double> duration = end - begin;
+    std::size_t n_work {0};
+    for(const auto& work : streams) {
+        n_work += work.size();
+    }
+    const auto events = static_cast<double>(n_work);
+    std::cout << name << ", " << stream_name(stream) << ", threads: " << streams.size() << ", "
+              << events / duration.count() / 1e6 << " Mevents/s";
+    if(counters.available()) {
+        std::cout << ", L1D misses/event " << static_cast<double>(misses[0]) / events
+                  << ", LLC misses/event " << static_cast<double>(misses[1]) / events;
+    } else {
+        std::cout << ", cache misses unavailable";
+    }
+    std::cout << std::endl;
+}
+
+template<Mode M>
+std::vector<FSM<M>> make_fleet()
+{
+    std::vector<FSM<M>> fleet {};
+    fleet.reserve(n_fsms);
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        fleet.push_back(scriptsizefsm::start<FSM<M>, OnState<M>>(10.));
+    }
+    return fleet;
+}
+
+int main()
+{
+    auto classic = make_fleet<Mode::classic>();
+    auto compact = make_fleet<Mode::compact>();
+    CacheCounters counters {};
+
+    std::cout << "fsms: " << n_fsms << ", events: " << n_events << "\n"
+              << "FSM: " << sizeof(FSM<Mode::classic>) << " bytes/fsm\n"
+              << "CompactFSM: " << sizeof(FSM<Mode::compact>) << " bytes/fsm" << std::endl;
+
+    const std::size_t max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    for(const Stream stream : {Stream::uniform, Stream::zipf, Stream::bursty}) {
+        for(std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+            std::vector<std::vector<Work>> streams {};
+            for(std::size_t thread = 0; thread < threads; ++thread) {
+                const std::size_t begin = n_fsms * thread / threads;
+                const std::size_t end = n_fsms * (thread + 1) / threads;
+                streams.push_back(make_stream(stream, begin, end - begin, n_events / threads));
+            }
+            bench<Mode::classic>("FSM", classic, streams, stream, counters);
+            bench<Mode::compact>("CompactFSM", compact, streams, stream, counters);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares producers locking a mutex around react against posting to a Mailbox
+ *
+ * Several producer threads send events to one FSM. In the first run each producer locks a mutex
+ * and calls react itself, in the second run the producers post to the mailbox and a single
+ * consumer thread drains it.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/mailbox.hpp"
+
+constexpr std::uint64_t n_events {1000000};
+
+class TickEvent : public scriptsizefsm::Event {
+  public:
+
+    TickEvent(std::uint64_t _value)
+      : value(_value) {};
+    std::uint64_t value;
+};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const TickEvent& event) const;
+};
+
+class CountingState : public GenericState {};
+
+class FSM
+  : public scriptsizefsm::FSM<FSM, GenericState>,
+    public scriptsizefsm::Mailbox<FSM, 1024> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+
+  public:
+
+    std::uint64_t sum {0};
+
+  protected:
+
+    FSM(const GenericState* const init_state)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state) {};
+};
+
+void GenericState::react(FSM* const fsm, const TickEvent& event) const
+{
+    fsm->sum += event.value;
+};
+
+template<class T_Func>
+double bench(std::size_t n_producers, T_Func&& produce)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers {};
+    for(std::size_t producer = 0; producer < n_producers; ++producer) {
+        producers.emplace_back([&produce, n_producers]() {
+            for(std::uint64_t event = 0; event < n_events / n_producers; ++event) {
+                produce(event);
+            }
+        });
+    }
+    for(auto& producer : producers) {
+        producer.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_events);
+}
+
+int main()
+{
+    const std::size_t n_producers = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+
+    auto locked_fsm = scriptsizefsm::start<FSM, CountingState>();
+    std::mutex mutex {};
+    const double locked_ns = bench(n_producers, [&locked_fsm, &mutex](std::uint64_t value) {
+        const std::lock_guard<std::mutex> lock {mutex};
+        locked_fsm.react(TickEvent(value));
+    });
+
+    auto posted_fsm = scriptsizefsm::start<FSM, CountingState>();
+    std::atomic<bool> producing {true};
+    std::thread consumer {[&posted_fsm, &producing]() {
+        while(producing || !posted_fsm.empty()) {
+            if(posted_fsm.drain() == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+    const double posted_ns = bench(n_producers, [&posted_fsm](std::uint64_t value) {
+        while(!posted_fsm.post(TickEvent(value))) {
+            std::this_thread::yield();
+        }
+    });
+    producing = false;
+    consumer.join();
+
+    std::cout << "producers: " << n_producers << ", events: " << n_events << "\n"
+              << "mutex + react: " << locked_ns << " ns/event\n"
+              << "mailbox post:  " << posted_ns << " ns/event\n"
+              << "speedup: " << locked_ns / posted_ns << std::endl;
+
+    return locked_fsm.sum == posted_fsm.sum ? 0 : 1;
+}
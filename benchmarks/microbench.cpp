@@ -0,0 +1,338 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief microbenchmarks of the basic FSM operations, written as JSON
+ *
+ * Measures `react` without and with a transition, `reset`, `is_in_state` and `start` for `FSM`,
+ * `VariantFSM`, `CompactFSM` and a hand-written switch, with 2 and 16 states and events, with 256
+ * states and with 64 and 256 events. States and events are scaled separately, since the compile
+ * time grows quickly with the number of events. Every state reacts to a stay event without
+ * transition and to a step event with a transition to the next state, the other events only pad
+ * the generic state. Each measurement is the best of several runs. The results are printed as JSON
+ * to stdout, or written to the file given as first argument, to track regressions between
+ * releases.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+constexpr std::uint64_t n_ops {10000000};
+constexpr int n_runs {5};
+
+/**
+ * @brief keeps the compiler from optimizing a value away
+ */
+template<class T_Value>
+inline void do_not_optimize(T_Value& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink = nullptr;
+    sink = &value;
+#endif
+}
+
+class StayEvent : public scriptsizefsm::Event {};
+
+class StepEvent : public scriptsizefsm::Event {};
+
+template<std::size_t E>
+class PadEvent : public scriptsizefsm::Event {};
+
+enum class Mode
+{
+    classic,
+    variant,
+    compact,
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+class FSM;
+
+// the pad events are declared in blocks of eight, the compile time of GCC with -Wall grows
+// steeply with the depth of a hierarchy of polymorphic classes
+template<
+    Mode M,
+    std::size_t N_States,
+    std::size_t N_Events,
+    std::size_t E = N_Events - 2,
+    bool N_Block = (E >= 8)>
+class GenericState : public GenericState<M, N_States, N_Events, E - 1> {
+  public:
+
+    using GenericState<M, N_States, N_Events, E - 1>::react;
+    virtual void react(FSM<M, N_States, N_Events>* const fsm, const PadEvent<E>& event) const {};
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events, std::size_t E>
+class GenericState<M, N_States, N_Events, E, true>
+  : public GenericState<M, N_States, N_Events, E - 8> {
+    using fsm_type = FSM<M, N_States, N_Events>;
+
+  public:
+
+    using GenericState<M, N_States, N_Events, E - 8>::react;
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 7>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 6>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 5>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 4>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 3>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 2>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E - 1>& event) const {};
+    virtual void react(fsm_type* const fsm, const PadEvent<E>& event) const {};
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+class GenericState<M, N_States, N_Events, 0, false>
+  : public scriptsizefsm::State<FSM<M, N_States, N_Events>> {
+  public:
+
+    virtual void react(FSM<M, N_States, N_Events>* const fsm, const StayEvent& event) const {};
+    virtual void react(FSM<M, N_States, N_Events>* const fsm, const StepEvent& event) const {};
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events, std::size_t S>
+class BenchState : public GenericState<M, N_States, N_Events> {
+  public:
+
+    void react(FSM<M, N_States, N_Events>* const fsm, const StayEvent& event) const override;
+    void react(FSM<M, N_States, N_Events>* const fsm, const StepEvent& event) const override;
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events, std::size_t... S>
+scriptsizefsm::StateList<BenchState<M, N_States, N_Events, S>...>
+    state_list(std::index_sequence<S...>);
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+using States = decltype(state_list<M, N_States, N_Events>(std::make_index_sequence<N_States> {}));
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+using InitState = BenchState<M, N_States, N_Events, 0>;
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+using FSMBase = std::conditional_t<
+    M == Mode::classic,
+    scriptsizefsm::FSM<FSM<M, N_States, N_Events>, GenericState<M, N_States, N_Events>>,
+    std::conditional_t<
+        M == Mode::variant,
+        scriptsizefsm::VariantFSM<
+            FSM<M, N_States, N_Events>,
+            GenericState<M, N_States, N_Events>,
+            States<M, N_States, N_Events>>,
+        scriptsizefsm::CompactFSM<
+            FSM<M, N_States, N_Events>,
+            GenericState<M, N_States, N_Events>,
+            States<M, N_States, N_Events>,
+            InitState<M, N_States, N_Events>>>>;
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+class FSM : public FSMBase<M, N_States, N_Events> {
+    friend FSMBase<M, N_States, N_Events>;
+
+  public:
+
+    std::uint64_t stays {0};
+
+  protected:
+
+    template<typename... T_Arg>
+    FSM(T_Arg... args)
+      : FSMBase<M, N_States, N_Events>(args...) {}
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events, std::size_t S>
+void BenchState<M, N_States, N_Events, S>::react(
+    FSM<M, N_States, N_Events>* const fsm,
+    const StayEvent& event
+) const
+{
+    ++fsm->stays;
+};
+
+template<Mode M, std::size_t N_States, std::size_t N_Events, std::size_t S>
+void BenchState<M, N_States, N_Events, S>::react(
+    FSM<M, N_States, N_Events>* const fsm,
+    const StepEvent& event
+) const
+{
+    this->template transit<BenchState<M, N_States, N_Events, (S + 1) % N_States>>(fsm);
+};
+
+/**
+ * @brief the same FSM as hand-written switch over the event
+ */
+template<std::size_t N_States, std::size_t N_Events>
+class SwitchFSM {
+  public:
+
+    static constexpr std::size_t stay_event = 0;
+    static constexpr std::size_t step_event = 1;
+
+    inline void react(std::size_t event)
+    {
+        switch(event) {
+        case stay_event:
+            ++stays;
+            break;
+        case step_event:
+            state = state + 1 == N_States ? 0 : state + 1;
+            break;
+        default:
+            break;
+        }
+    }
+
+    inline void reset()
+    {
+        state = 0;
+    }
+
+    std::size_t state {0};
+    std::uint64_t stays {0};
+};
+
+/**
+ * @brief single measurement
+ */
+struct Result {
+    std::string fsm;
+    std::size_t states;
+    std::size_t events;
+    std::string operation;
+    double ns_per_op;
+};
+
+/**
+ * @brief best time per call of a function over several runs
+ */
+template<class T_Func>
+double measure(T_Func&& func)
+{
+    double best = 0;
+    for(int run = 0; run < n_runs; ++run) {
+        const auto begin = std::chrono::steady_clock::now();
+        for(std::uint64_t op = 0; op < n_ops; ++op) {
+            func();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const std::chrono::duration<double, std::nano> duration = end - begin;
+        const double ns = duration.count() / static_cast<double>(n_ops);
+        best = run == 0 ? ns : std::min(best, ns);
+    }
+    return best;
+}
+
+template<Mode M, std::size_t N_States, std::size_t N_Events>
+void bench_fsm(const std::string& name, std::vector<Result>& results)
+{
+    using T_FSM = FSM<M, N_States, N_Events>;
+    using T_Init = InitState<M, N_States, N_Events>;
+    const auto add = [&](const char* operation, double ns) {
+        results.push_back(Result {name, N_States, N_Events, operation, ns});
+    };
+
+    auto fsm = scriptsizefsm::start<T_FSM, T_Init>();
+    add("react", measure([&fsm]() {
+            fsm.react(StayEvent());
+        }));
+    add("react_transit", measure([&fsm]() {
+            fsm.react(StepEvent());
+        }));
+    add("reset", measure([&fsm]() {
+            fsm.reset();
+            do_not_optimize(fsm);
+        }));
+    add("is_in_state", measure([&fsm]() {
+            bool in_state = fsm.template is_in_state<T_Init>();
+            do_not_optimize(in_state);
+        }));
+    add("start", measure([]() {
+            auto started = scriptsizefsm::start<T_FSM, T_Init>();
+            do_not_optimize(started);
+        }));
+    do_not_optimize(fsm.stays);
+}
+
+template<std::size_t N_States, std::size_t N_Events>
+void bench_switch(std::vector<Result>& results)
+{
+    using T_FSM = SwitchFSM<N_States, N_Events>;
+    const auto add = [&](const char* operation, double ns) {
+        results.push_back(Result {"switch", N_States, N_Events, operation, ns});
+    };
+
+    T_FSM fsm {};
+    add("react", measure([&fsm]() {
+            fsm.react(T_FSM::stay_event);
+            do_not_optimize(fsm);
+        }));
+    add("react_transit", measure([&fsm]() {
+            fsm.react(T_FSM::step_event);
+            do_not_optimize(fsm);
+        }));
+    add("reset", measure([&fsm]() {
+            fsm.reset();
+            do_not_optimize(fsm);
+        }));
+    add("is_in_state", measure([&fsm]() {
+            bool in_state = fsm.state == 0;
+            do_not_optimize(in_state);
+        }));
+    add("start", measure([]() {
+            T_FSM started {};
+            do_not_optimize(started);
+        }));
+}
+
+template<std::size_t N_States, std::size_t N_Events>
+void bench_size(std::vector<Result>& results)
+{
+    bench_fsm<Mode::classic, N_States, N_Events>("FSM", results);
+    bench_fsm<Mode::variant, N_States, N_Events>("VariantFSM", results);
+    bench_fsm<Mode::compact, N_States, N_Events>("CompactFSM", results);
+    bench_switch<N_States, N_Events>(results);
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<Result> results {};
+    bench_size<2, 2>(results);
+    bench_size<16, 16>(results);
+    bench_size<256, 2>(results);
+    bench_size<2, 64>(results);
+    bench_size<2, 256>(results);
+
+    std::ostringstream json {};
+    json << "{\n  \"ops_per_run\": " << n_ops << ",\n  \"runs\": " << n_runs
+         << ",\n  \"results\": [\n";
+    for(std::size_t index = 0; index < results.size(); ++index) {
+        const auto& result = results[index];
+        json << "    {\"fsm\": \"" << result.fsm << "\", \"states\": " << result.states
+             << ", \"events\": " << result.events << ", \"operation\": \"" << result.operation
+             << "\", \"ns_per_op\": " << result.ns_per_op << "}"
+             << (index + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if(argc > 1) {
+        std::ofstream file {argv[1]};
+        file << json.str();
+        return file ? 0 : 1;
+    }
+    std::cout << json.str() << std::flush;
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief measures the scaling of parallel_broadcast with the number of threads
+ *
+ * A fleet of ten million FSMs with a data column receives alternating events. The broadcast is
+ * timed for one thread and then for doubling thread counts up to the hardware concurrency.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+
+#include "scriptsizefsm/parallel.hpp"
+
+constexpr std::size_t n_fsms {10000000};
+constexpr std::size_t n_rounds {10};
+
+class OnEvent : public scriptsizefsm::Event {};
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OffState, OnState>;
+
+class FSM : public scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, double> {
+    friend scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, double>;
+
+  public:
+
+    inline double& energy()
+    {
+        return column<double>();
+    };
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->energy() += 1.;
+    transit<OnState>(fsm);
+};
+
+double bench(scriptsizefsm::Fleet<FSM>& fleet, std::size_t threads)
+{
+    scriptsizefsm::ThreadPool pool {threads};
+    std::size_t transitions {0};
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < n_rounds; ++round) {
+        transitions += scriptsizefsm::parallel_broadcast(pool, fleet, OnEvent()).transitions;
+        transitions += scriptsizefsm::parallel_broadcast(pool, fleet, OffEvent()).transitions;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    if(transitions != 2 * n_rounds * n_fsms) {
+        std::cerr << "unexpected number of transitions: " << transitions << std::endl;
+    }
+    return duration.count() / static_cast<double>(2 * n_rounds * n_fsms);
+}
+
+int main()
+{
+    scriptsizefsm::Fleet<FSM> fleet {};
+    fleet.reserve(n_fsms);
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        fleet.add(0.);
+    }
+
+    const std::size_t max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    const double single_ns = bench(fleet, 1);
+    std::cout << "fsms: " << n_fsms << "\n"
+              << "threads: 1, " << single_ns << " ns/fsm" << std::endl;
+    for(std::size_t threads = 2; threads <= max_threads; threads *= 2) {
+        const double ns = bench(fleet, threads);
+        std::cout << "threads: " << threads << ", " << ns << " ns/fsm, speedup "
+                  << single_ns / ns << std::endl;
+    }
+
+    return 0;
+}
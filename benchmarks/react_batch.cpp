@@ -0,0 +1,129 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares reacting FSM by FSM against the group-by-state dispatch react_batch
+ *
+ * One million CompactFSMs with 16 states are distributed randomly over their states, so reacting
+ * to an event one FSM after the other jumps to an unpredictable state reaction every time. The
+ * batched dispatch sorts the FSMs by state first and then calls each reaction in a tight loop.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/fleet.hpp"
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+constexpr std::size_t n_states {16};
+constexpr std::size_t n_fsms {1000000};
+constexpr std::size_t n_rounds {50};
+
+class TickEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const TickEvent& event) const {};
+};
+
+template<std::size_t S>
+class BenchState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const TickEvent& event) const override;
+};
+
+template<std::size_t... I>
+auto make_states(std::index_sequence<I...>) -> scriptsizefsm::StateList<BenchState<I>...>;
+
+using States = decltype(make_states(std::make_index_sequence<n_states> {}));
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, BenchState<0>> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, BenchState<0>>;
+
+  public:
+
+    std::uint32_t value {0};
+
+  protected:
+
+    FSM() = default;
+};
+
+template<std::size_t S>
+void BenchState<S>::react(FSM* const fsm, const TickEvent& event) const
+{
+    fsm->value = fsm->value * (2 * S + 3) + S;
+    if(fsm->value % 8 == 0) {
+        this->template transit<BenchState<(S * 5 + 3) % n_states>>(fsm);
+    }
+}
+
+std::vector<FSM> make_fsms()
+{
+    std::mt19937 rng {42};
+    std::uniform_int_distribution<std::size_t> state_dist {0, n_states - 1};
+
+    std::vector<FSM> fsms {};
+    fsms.reserve(n_fsms);
+    for(std::size_t index = 0; index < n_fsms; ++index) {
+        fsms.push_back(scriptsizefsm::start<FSM, BenchState<0>>());
+        // walk the FSM into a random state
+        const auto state = state_dist(rng);
+        while(fsms.back().state_id() != state) {
+            fsms.back().react(TickEvent());
+        }
+    }
+    return fsms;
+}
+
+template<class T_Func>
+double bench(T_Func&& func)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < n_rounds; ++round) {
+        func();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_rounds * n_fsms);
+}
+
+int main()
+{
+    auto naive_fsms = make_fsms();
+    auto batch_fsms = naive_fsms;
+
+    const auto naive_ns = bench([&naive_fsms]() {
+        for(auto& fsm : naive_fsms) {
+            fsm.react(TickEvent());
+        }
+    });
+    const auto batch_ns = bench([&batch_fsms]() {
+        scriptsizefsm::react_batch(batch_fsms, TickEvent());
+    });
+
+    std::uint64_t naive_sum {0};
+    std::uint64_t batch_sum {0};
+    for(std::size_t index = 0; index < n_fsms; ++index) {
+        naive_sum += naive_fsms[index].value + naive_fsms[index].state_id();
+        batch_sum += batch_fsms[index].value + batch_fsms[index].state_id();
+    }
+
+    std::cout << "fsms: " << n_fsms << ", states: " << n_states << "\n"
+              << "naive dispatch: " << naive_ns << " ns/fsm\n"
+              << "batch dispatch: " << batch_ns << " ns/fsm\n"
+              << "speedup: " << naive_ns / batch_ns << std::endl;
+
+    return naive_sum == batch_sum ? 0 : 1;
+}
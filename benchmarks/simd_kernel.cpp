@@ -0,0 +1,95 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares the scalar and the vectorized path of TransitionKernel
+ *
+ * Ten million FSMs with 16 states advance through random event columns. With SSSE3 or AVX2
+ * enabled, the vectorized path should be limited by memory bandwidth instead of the lookups.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/simd.hpp"
+
+constexpr std::size_t n_states {16};
+constexpr std::size_t n_fsms {10000000};
+constexpr std::size_t n_rounds {20};
+
+class FSM;
+
+template<std::size_t S>
+class BenchState : public scriptsizefsm::State<FSM> {};
+
+template<std::size_t E>
+class BenchEvent : public scriptsizefsm::Event {};
+
+template<std::size_t... I>
+auto make_kernel(std::index_sequence<I...>) -> scriptsizefsm::TransitionKernel<
+    scriptsizefsm::StateList<BenchState<I>...>,
+    scriptsizefsm::EventList<BenchEvent<0>, BenchEvent<1>, BenchEvent<2>>,
+    scriptsizefsm::TransitionTable<
+        scriptsizefsm::Row<BenchState<I>, BenchEvent<0>, BenchState<(I + 1) % n_states>>...,
+        scriptsizefsm::Row<BenchState<I>, BenchEvent<1>, BenchState<(I * 5 + 3) % n_states>>...,
+        scriptsizefsm::Row<BenchState<I>, BenchEvent<2>, BenchState<0>>...>>;
+
+using Kernel = decltype(make_kernel(std::make_index_sequence<n_states> {}));
+
+template<class T_Func>
+double bench(
+    std::vector<std::uint8_t>& states,
+    const std::vector<std::uint8_t>& events,
+    T_Func&& func
+)
+{
+    std::size_t changes {0};
+    const auto count = [&changes](std::size_t, std::uint8_t, std::uint8_t) { ++changes; };
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < n_rounds; ++round) {
+        func(states.data(), events.data(), states.size(), count);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    std::cout << "  " << changes << " transitions" << std::endl;
+    return duration.count() / static_cast<double>(n_rounds * n_fsms);
+}
+
+int main()
+{
+    std::mt19937 rng {42};
+    // a quarter of the FSMs gets no event
+    std::uniform_int_distribution<std::size_t> event_dist {0, 3};
+    std::vector<std::uint8_t> events(n_fsms);
+    for(auto& event : events) {
+        const auto index = event_dist(rng);
+        event = index < 3 ? static_cast<std::uint8_t>(index) : Kernel::no_event;
+    }
+
+    std::vector<std::uint8_t> scalar_states(n_fsms, 0);
+    std::vector<std::uint8_t> vector_states(n_fsms, 0);
+
+    std::cout << "scalar:" << std::endl;
+    const auto scalar_ns = bench(scalar_states, events, [](auto... args) {
+        Kernel::advance_scalar(args...);
+    });
+    std::cout << "vectorized:" << std::endl;
+    const auto vector_ns = bench(vector_states, events, [](auto... args) {
+        Kernel::advance(args...);
+    });
+
+    std::cout << "fsms: " << n_fsms << ", states: " << n_states << "\n"
+              << "scalar kernel:     " << scalar_ns << " ns/fsm\n"
+              << "vectorized kernel: " << vector_ns << " ns/fsm, "
+              << 2. / vector_ns << " GB/s column traffic\n"
+              << "speedup: " << scalar_ns / vector_ns << std::endl;
+
+    return scalar_states == vector_states ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares state timeouts kept in a std::multimap against scriptsizefsm::TimerWheel
+ *
+ * A population of FSMs keeps arming a timeout, most of them are cancelled again before they
+ * expire, like for states that usually receive their event in time. Every tick one FSM in ten
+ * re-arms its timeout after the time advanced, which fires the timeouts that were not cancelled.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "scriptsizefsm/timer.hpp"
+
+constexpr std::size_t n_fsms {1000000};
+constexpr std::size_t n_ticks {200};
+constexpr std::size_t n_rearm_per_tick {n_fsms / 10};
+constexpr std::uint64_t timeout {100};
+
+class Entry : public scriptsizefsm::Timer {
+  public:
+
+    static void expire(scriptsizefsm::Timer& timer)
+    {
+        ++static_cast<Entry&>(timer).expired;
+    }
+
+    std::uint64_t expired {0};
+};
+
+template<class T_Func>
+double bench(T_Func&& func)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_ticks * n_rearm_per_tick);
+}
+
+int main()
+{
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<std::size_t> distribution {0, n_fsms - 1};
+    std::vector<std::size_t> order(n_ticks * n_rearm_per_tick);
+    for(auto& id : order) {
+        id = distribution(generator);
+    }
+
+    // deadlines in a multimap, each FSM keeps the iterator of its deadline
+    using Deadlines = std::multimap<std::uint64_t, std::size_t>;
+    Deadlines deadlines {};
+    std::vector<Deadlines::iterator> handles(n_fsms, deadlines.end());
+    std::vector<std::uint64_t> map_expired(n_fsms, 0);
+    const double map_ns = bench([&]() {
+        for(std::uint64_t tick = 1; tick <= n_ticks; ++tick) {
+            while(!deadlines.empty() && deadlines.begin()->first <= tick) {
+                const std::size_t id = deadlines.begin()->second;
+                ++map_expired[id];
+                handles[id] = deadlines.end();
+                deadlines.erase(deadlines.begin());
+            }
+            for(std::size_t index = 0; index < n_rearm_per_tick; ++index) {
+                const std::size_t id = order[(tick - 1) * n_rearm_per_tick + index];
+                if(handles[id] != deadlines.end()) {
+                    deadlines.erase(handles[id]);
+                }
+                handles[id] = deadlines.emplace(tick + timeout, id);
+            }
+        }
+    });
+
+    scriptsizefsm::TimerWheel wheel {&Entry::expire};
+    std::unique_ptr<Entry[]> entries {new Entry[n_fsms]};
+    const double wheel_ns = bench([&]() {
+        for(std::uint64_t tick = 1; tick <= n_ticks; ++tick) {
+            wheel.advance(tick);
+            for(std::size_t index = 0; index < n_rearm_per_tick; ++index) {
+                wheel.arm(entries[order[(tick - 1) * n_rearm_per_tick + index]], timeout);
+            }
+        }
+    });
+
+    bool same = true;
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        same = same && map_expired[id] == entries[id].expired;
+    }
+
+    std::cout << "fsms: " << n_fsms << ", re-armed per tick: " << n_rearm_per_tick << "\n"
+              << "multimap:    " << map_ns << " ns/arm\n"
+              << "timer wheel: " << wheel_ns << " ns/arm\n"
+              << "speedup: " << map_ns / wheel_ns << std::endl;
+
+    return same ? 0 : 1;
+}
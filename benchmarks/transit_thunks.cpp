@@ -0,0 +1,109 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares the transit modes of CompactFSM
+ *
+ * A ring of 16 states, each with entry and exit functions, is driven around by an event that
+ * always causes a transition to the next state. The time per transition is measured with the
+ * default `TransitMode::dispatch` and with `TransitMode::thunks`.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+using scriptsizefsm::TransitMode;
+
+constexpr std::size_t n_states {16};
+constexpr std::uint64_t n_transitions {100000000};
+
+class StepEvent : public scriptsizefsm::Event {};
+
+template<TransitMode M>
+class FSM;
+
+template<TransitMode M>
+class GenericState : public scriptsizefsm::State<FSM<M>> {
+  public:
+
+    virtual void react(FSM<M>* const fsm, const StepEvent& event) const {};
+};
+
+template<TransitMode M, std::size_t S>
+class RingState : public GenericState<M> {
+  public:
+
+    void entry(FSM<M>* const fsm) const override;
+    void exit(FSM<M>* const fsm) const override;
+    void react(FSM<M>* const fsm, const StepEvent& event) const override;
+};
+
+template<TransitMode M, std::size_t... S>
+scriptsizefsm::StateList<RingState<M, S>...> state_list(std::index_sequence<S...>);
+
+template<TransitMode M>
+using States = decltype(state_list<M>(std::make_index_sequence<n_states> {}));
+
+template<TransitMode M>
+class FSM : public scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, RingState<M, 0>> {
+    friend scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, RingState<M, 0>>;
+
+  public:
+
+    static constexpr TransitMode transit_mode = M;
+
+    std::uint64_t entries {0};
+    std::uint64_t exits {0};
+};
+
+template<TransitMode M, std::size_t S>
+void RingState<M, S>::entry(FSM<M>* const fsm) const
+{
+    fsm->entries += S;
+};
+
+template<TransitMode M, std::size_t S>
+void RingState<M, S>::exit(FSM<M>* const fsm) const
+{
+    fsm->exits += S;
+};
+
+template<TransitMode M, std::size_t S>
+void RingState<M, S>::react(FSM<M>* const fsm, const StepEvent& event) const
+{
+    this->template transit<RingState<M, (S + 1) % n_states>>(fsm);
+};
+
+template<TransitMode M>
+double bench()
+{
+    auto fsm = scriptsizefsm::start<FSM<M>, RingState<M, 0>>();
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::uint64_t transition = 0; transition < n_transitions; ++transition) {
+        fsm.react(StepEvent());
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    if(fsm.entries != fsm.exits + (n_transitions % n_states)) {
+        std::cerr << "unexpected number of entries and exits" << std::endl;
+    }
+    return duration.count() / static_cast<double>(n_transitions);
+}
+
+int main()
+{
+    const double dispatch_ns = bench<TransitMode::dispatch>();
+    const double thunks_ns = bench<TransitMode::thunks>();
+    std::cout << "states: " << n_states << "\n"
+              << "dispatch: " << dispatch_ns << " ns/transition\n"
+              << "thunks: " << thunks_ns << " ns/transition" << std::endl;
+
+    return 0;
+}
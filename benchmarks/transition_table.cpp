@@ -0,0 +1,246 @@
+/**
+ * @file
+ * \ingroup benchmarks
+ * @brief compares the virtual dispatch of FSM against the transition table of TableFSM
+ *
+ * Both machines have 64 states and 64 events. A quarter of the (state, event) pairs cause a
+ * transition, the remaining pairs are ignored. The events are sent in a fixed pseudo-random order
+ * that is unrolled at compile time, so the benchmark loop itself does not dispatch anything.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+#include "scriptsizefsm/table.hpp"
+
+constexpr std::size_t n_states {64};
+constexpr std::size_t n_events {64};
+constexpr std::size_t n_rounds {200000};
+
+constexpr bool handles(std::size_t state, std::size_t event)
+{
+    return (state + event) % 4 == 0;
+}
+
+constexpr std::size_t target(std::size_t state, std::size_t event)
+{
+    return (state * 7 + event + 1) % n_states;
+}
+
+constexpr std::size_t event_order(std::size_t index)
+{
+    return (index * 37 + 11) % n_events;
+}
+
+template<std::size_t E>
+class BenchEvent : public scriptsizefsm::Event {};
+
+namespace virtual_dispatch {
+
+    class FSM;
+
+    // the reactions are declared in blocks of eight per class, deep inheritance chains of
+    // polymorphic classes compile slowly
+    static_assert(n_events % 8 == 0);
+
+    template<std::size_t E>
+    class GenericReact : public GenericReact<E - 8> {
+      public:
+
+        using GenericReact<E - 8>::react;
+        virtual void react(FSM* const fsm, const BenchEvent<E - 8>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 7>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 6>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 5>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 4>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 3>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 2>& event) const {};
+        virtual void react(FSM* const fsm, const BenchEvent<E - 1>& event) const {};
+    };
+
+    template<>
+    class GenericReact<0> : public scriptsizefsm::State<FSM> {};
+
+    using GenericState = GenericReact<n_events>;
+
+    template<std::size_t S>
+    class BenchState;
+
+    template<std::size_t S, std::size_t E>
+    class StateReact : public StateReact<S, E - 8> {
+      public:
+
+        using StateReact<S, E - 8>::react;
+        void react(FSM* const fsm, const BenchEvent<E - 8>& event) const override
+        {
+            this->template on_event<E - 8>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 7>& event) const override
+        {
+            this->template on_event<E - 7>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 6>& event) const override
+        {
+            this->template on_event<E - 6>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 5>& event) const override
+        {
+            this->template on_event<E - 5>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 4>& event) const override
+        {
+            this->template on_event<E - 4>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 3>& event) const override
+        {
+            this->template on_event<E - 3>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 2>& event) const override
+        {
+            this->template on_event<E - 2>(fsm);
+        };
+        void react(FSM* const fsm, const BenchEvent<E - 1>& event) const override
+        {
+            this->template on_event<E - 1>(fsm);
+        };
+    };
+
+    template<std::size_t S>
+    class StateReact<S, 0> : public GenericState {
+      protected:
+
+        template<std::size_t E>
+        void on_event(FSM* const fsm) const;
+    };
+
+    template<std::size_t S>
+    class BenchState : public StateReact<S, n_events> {};
+
+    class FSM : public scriptsizefsm::FSM<FSM, GenericState> {
+        friend scriptsizefsm::FSM<FSM, GenericState>;
+
+      public:
+
+        std::uint64_t transitions {0};
+
+      protected:
+
+        FSM(const GenericState* const init_state)
+          : scriptsizefsm::FSM<FSM, GenericState>(init_state) {};
+    };
+
+    template<std::size_t S>
+    template<std::size_t E>
+    void StateReact<S, 0>::on_event(FSM* const fsm) const
+    {
+        if constexpr(handles(S, E)) {
+            ++fsm->transitions;
+            this->template transit<BenchState<target(S, E)>>(fsm);
+        }
+    }
+
+}  // namespace virtual_dispatch
+
+namespace table_dispatch {
+
+    class FSM;
+
+    template<std::size_t S>
+    class BenchState : public scriptsizefsm::State<FSM> {};
+
+    template<std::size_t E>
+    void count(FSM* const fsm, const BenchEvent<E>& event);
+
+    template<std::size_t I>
+    using BenchRow = scriptsizefsm::Row<
+        BenchState<I / n_events>,
+        BenchEvent<I % n_events>,
+        BenchState<target(I / n_events, I % n_events)>,
+        &count<I % n_events>>;
+
+    template<class... T_Rows>
+    struct Rows {
+        using table = scriptsizefsm::TransitionTable<T_Rows...>;
+    };
+
+    template<class... T_Rows_A, class... T_Rows_B>
+    Rows<T_Rows_A..., T_Rows_B...> operator+(Rows<T_Rows_A...>, Rows<T_Rows_B...>);
+
+    template<std::size_t... I>
+    auto make_rows(std::index_sequence<I...>)
+        -> decltype((std::conditional_t<handles(I / n_events, I % n_events), Rows<BenchRow<I>>, Rows<>> {} + ...));
+
+    template<std::size_t... I>
+    auto make_states(std::index_sequence<I...>) -> scriptsizefsm::StateList<BenchState<I>...>;
+
+    template<std::size_t... I>
+    auto make_events(std::index_sequence<I...>) -> scriptsizefsm::EventList<BenchEvent<I>...>;
+
+    using States = decltype(make_states(std::make_index_sequence<n_states> {}));
+    using Events = decltype(make_events(std::make_index_sequence<n_events> {}));
+    using Table = typename decltype(make_rows(std::make_index_sequence<n_states * n_events> {}))::table;
+
+    class FSM : public scriptsizefsm::TableFSM<FSM, States, Events, Table> {
+        friend scriptsizefsm::TableFSM<FSM, States, Events, Table>;
+
+      public:
+
+        std::uint64_t transitions {0};
+
+      protected:
+
+        FSM(const scriptsizefsm::State<FSM>* const init_state)
+          : scriptsizefsm::TableFSM<FSM, States, Events, Table>(init_state) {};
+    };
+
+    template<std::size_t E>
+    void count(FSM* const fsm, const BenchEvent<E>& event)
+    {
+        ++fsm->transitions;
+    }
+
+}  // namespace table_dispatch
+
+template<class T_FSM, std::size_t... I>
+void run_round(T_FSM& fsm, std::index_sequence<I...>)
+{
+    (fsm.react(BenchEvent<event_order(I)> {}), ...);
+}
+
+template<class T_FSM>
+double bench(T_FSM& fsm)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    for(std::size_t round = 0; round < n_rounds; ++round) {
+        run_round(fsm, std::make_index_sequence<n_events> {});
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const std::chrono::duration<double, std::nano> duration = end - begin;
+    return duration.count() / static_cast<double>(n_rounds * n_events);
+}
+
+int main()
+{
+    auto virtual_fsm =
+        scriptsizefsm::start<virtual_dispatch::FSM, virtual_dispatch::BenchState<0>>();
+    auto table_fsm = scriptsizefsm::start<table_dispatch::FSM, table_dispatch::BenchState<0>>();
+
+    const auto virtual_ns = bench(virtual_fsm);
+    const auto table_ns = bench(table_fsm);
+
+    std::cout << "states: " << n_states << ", events: " << n_events << "\n"
+              << "virtual dispatch: " << virtual_ns << " ns/event, "
+              << virtual_fsm.transitions << " transitions\n"
+              << "table dispatch:   " << table_ns << " ns/event, " << table_fsm.transitions
+              << " transitions\n"
+              << "speedup: " << virtual_ns / table_ns << std::endl;
+
+    return virtual_fsm.transitions == table_fsm.transitions ? 0 : 1;
+}
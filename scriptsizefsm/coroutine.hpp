@@ -0,0 +1,628 @@
+/**
+ * @file
+ * @brief C++20 coroutine front end, writing a protocol as a sequence of awaited events
+ *
+ * Instead of one `State` subclass per step, a `CoroutineFSM` implements a single `protocol`
+ * coroutine that suspends with `co_await next<EventA, EventB>()`. `react` compares the event type
+ * against the few awaited types and resumes the coroutine directly, without a virtual dispatch or
+ * `exit`/`entry` calls. States are only labels set with `set_state`, so that `is_in_state` works
+ * like for the other FSMs. The coroutine frames can be allocated from a `FramePool` shared by many
+ * FSMs.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || __cpp_impl_coroutine < 201902L
+#error "scriptsizefsm/coroutine.hpp requires C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * @brief pool for coroutine frames of many FSMs
+     *
+     * Frames are rounded up to size classes of 64 bytes, each size class keeps a free list that is
+     * refilled a chunk of blocks at a time, so starting and resetting protocols does not allocate
+     * once the pool is warm. The pool is not thread-safe and has to outlive all FSMs using it.
+     */
+    class FramePool {
+
+      public:
+
+        /**
+         * @brief pool constructor
+         * @param blocks_per_chunk number of frames allocated at once per size class
+         */
+        explicit FramePool(std::size_t blocks_per_chunk = 64)
+          : blocks_per_chunk_(blocks_per_chunk > 0 ? blocks_per_chunk : 1) {};
+
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        ~FramePool()
+        {
+            for(auto* const chunk : chunks_) {
+                ::operator delete(chunk, std::align_val_t {granularity});
+            }
+        };
+
+        /**
+         * @brief allocates memory for a frame
+         * @param size size of the frame in bytes
+         */
+        void* allocate(std::size_t size)
+        {
+            const std::size_t size_class = (size + granularity - 1) / granularity;
+            if(size_class >= free_.size()) {
+                free_.resize(size_class + 1, nullptr);
+            }
+            if(free_[size_class] == nullptr) {
+                refill(size_class);
+            }
+            Block* const block = free_[size_class];
+            free_[size_class] = block->next;
+            ++in_use_;
+            return block;
+        }
+
+        /**
+         * @brief returns the memory of a frame to the pool
+         * @param frame memory returned by allocate
+         * @param size size passed to allocate
+         */
+        void deallocate(void* const frame, std::size_t size)
+        {
+            const std::size_t size_class = (size + granularity - 1) / granularity;
+            free_[size_class] = ::new(frame) Block {free_[size_class]};
+            --in_use_;
+        }
+
+        /**
+         * @brief number of frames currently allocated from the pool
+         */
+        inline std::size_t in_use() const
+        {
+            return in_use_;
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief granularity of the size classes, also the alignment of the blocks
+         */
+        static constexpr std::size_t granularity = 64;
+
+        /**
+         * \internal
+         * @brief free block in a free list
+         */
+        struct Block {
+            Block* next;
+        };
+
+        /**
+         * \internal
+         * @brief allocates a chunk of blocks for a size class
+         */
+        void refill(std::size_t size_class)
+        {
+            const std::size_t block_size = size_class * granularity;
+            auto* const chunk = static_cast<unsigned char*>(::operator new(
+                block_size * blocks_per_chunk_, std::align_val_t {granularity}
+            ));
+            chunks_.push_back(chunk);
+            for(std::size_t block = 0; block < blocks_per_chunk_; ++block) {
+                free_[size_class] = ::new(chunk + block * block_size) Block {free_[size_class]};
+            }
+        }
+
+        std::size_t blocks_per_chunk_;
+        std::size_t in_use_ {0};
+        std::vector<Block*> free_;
+        std::vector<void*> chunks_;
+    };
+
+    /**
+     * \internal
+     * @brief unique address per event type, used to match events against awaited types
+     */
+    template<class T_Event>
+    inline constexpr char _event_key {};
+
+    /**
+     * @brief return type of the protocol coroutine of a `CoroutineFSM`
+     */
+    class Coroutine {
+
+      public:
+
+        /**
+         * @brief promise of the protocol coroutine
+         */
+        struct promise_type {
+            Coroutine get_return_object()
+            {
+                return Coroutine {std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+            void return_void() {}
+            void unhandled_exception()
+            {
+                throw;
+            }
+
+            /**
+             * @brief allocates the frame from the pool of the FSM the protocol belongs to
+             * @param owner FSM the protocol is a member function of
+             */
+            template<class T_Owner, class... T_Arg>
+            static void* operator new(std::size_t size, T_Owner& owner, T_Arg&... /*args*/)
+            {
+                return allocate(size, owner.frame_pool());
+            }
+            static void* operator new(std::size_t size)
+            {
+                return allocate(size, nullptr);
+            }
+            static void operator delete(void* const frame, std::size_t size)
+            {
+                auto* const header = static_cast<Header*>(frame) - 1;
+                if(header->pool != nullptr) {
+                    header->pool->deallocate(header, size + sizeof(Header));
+                } else {
+                    ::operator delete(header);
+                }
+            }
+
+            /**
+             * \internal
+             * @brief keys of the awaited event types
+             */
+            const void* const* keys {nullptr};
+
+            /**
+             * \internal
+             * @brief number of awaited event types
+             */
+            std::size_t n_keys {0};
+
+            /**
+             * \internal
+             * @brief event the coroutine was resumed with
+             */
+            const void* event {nullptr};
+
+            /**
+             * \internal
+             * @brief index of the type of that event in the awaited types
+             */
+            std::size_t matched {0};
+
+          private:
+
+            /**
+             * \internal
+             * @brief remembers the pool a frame was allocated from
+             */
+            struct alignas(std::max_align_t) Header {
+                FramePool* pool;
+            };
+
+            static void* allocate(std::size_t size, FramePool* const pool)
+            {
+                void* const memory = pool != nullptr ? pool->allocate(size + sizeof(Header))
+                                                     : ::operator new(size + sizeof(Header));
+                return ::new(memory) Header {pool} + 1;
+            }
+        };
+
+        Coroutine() = default;
+
+        Coroutine(Coroutine&& other) noexcept
+          : handle_(std::exchange(other.handle_, nullptr)) {};
+
+        Coroutine& operator=(Coroutine&& other) noexcept
+        {
+            if(this != &other) {
+                if(handle_) {
+                    handle_.destroy();
+                }
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        };
+
+        ~Coroutine()
+        {
+            if(handle_) {
+                handle_.destroy();
+            }
+        };
+
+        /**
+         * @brief checks if the coroutine was started
+         */
+        inline bool started() const
+        {
+            return static_cast<bool>(handle_);
+        }
+
+        /**
+         * @brief checks if the coroutine ran to its end
+         */
+        inline bool done() const
+        {
+            return handle_ && handle_.done();
+        }
+
+        /**
+         * \internal
+         * @brief handle of the coroutine
+         */
+        inline std::coroutine_handle<promise_type> _handle() const
+        {
+            return handle_;
+        }
+
+      private:
+
+        explicit Coroutine(std::coroutine_handle<promise_type> handle)
+          : handle_(handle) {};
+
+        std::coroutine_handle<promise_type> handle_ {nullptr};
+    };
+
+    /**
+     * @brief event received by awaiting more than one event type
+     * @tparam T_Events awaited event types
+     */
+    template<class... T_Events>
+    class Received {
+
+      public:
+
+        /**
+         * @brief checks if the received event is of a given type
+         */
+        template<class T_Event>
+        inline bool is() const
+        {
+            return index_ == index_of<T_Event, TypeList<T_Events...>>;
+        }
+
+        /**
+         * @brief received event, valid until the coroutine suspends again
+         * @tparam T_Event type of the event, has to match `is`
+         */
+        template<class T_Event>
+        inline const T_Event& get() const
+        {
+            return *static_cast<const T_Event*>(event_);
+        }
+
+        /**
+         * @brief index of the type of the received event in T_Events
+         */
+        inline std::size_t index() const
+        {
+            return index_;
+        }
+
+        /**
+         * \internal
+         * @brief constructor
+         */
+        Received(const void* const event, std::size_t index)
+          : event_(event),
+            index_(index) {};
+
+      private:
+
+        const void* event_;
+        std::size_t index_;
+    };
+
+    /**
+     * \internal
+     * @brief first type of a parameter pack
+     */
+    template<class T_First, class... T_Rest>
+    struct _first_type {
+        using type = T_First;
+    };
+
+    /**
+     * \internal
+     * @brief awaiter suspending the protocol until one of the given event types is received
+     */
+    template<class... T_Events>
+    class _next_awaiter {
+
+        static_assert(sizeof...(T_Events) > 0, "await at least one event type");
+
+      public:
+
+        inline bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        inline void await_suspend(std::coroutine_handle<Coroutine::promise_type> handle) noexcept
+        {
+            promise_ = &handle.promise();
+            promise_->keys = keys;
+            promise_->n_keys = sizeof...(T_Events);
+        }
+
+        /**
+         * \internal
+         * @brief the event for a single awaited type, otherwise a `Received`
+         */
+        inline decltype(auto) await_resume() const
+        {
+            if constexpr(sizeof...(T_Events) == 1) {
+                using event_type = typename _first_type<T_Events...>::type;
+                return *static_cast<const event_type*>(promise_->event);
+            } else {
+                return Received<T_Events...> {promise_->event, promise_->matched};
+            }
+        }
+
+      private:
+
+        static constexpr const void* keys[] = {&_event_key<T_Events>...};
+
+        Coroutine::promise_type* promise_ {nullptr};
+    };
+
+    /**
+     * @brief Finite State Machine class implemented by a coroutine
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_State_List `StateList` of the state labels of the FSM
+     * @tparam T_State_Init initial state label of the FSM
+     *
+     * The FSM implementation provides a member function `Coroutine protocol()`. It is started by
+     * the first event, then every `react` resumes it if it awaits the type of the event, events of
+     * other types are ignored. Events raised by the protocol itself are queued and dispatched once
+     * it suspended again. Since the coroutine refers to the FSM, a `CoroutineFSM` can not be copied
+     * or moved.
+     */
+    template<class T_FSM_Child, class T_State_List, class T_State_Init>
+    class CoroutineFSM {
+
+      public:
+
+        /**
+         * @brief list of all state labels of the FSM
+         */
+        using state_list = T_State_List;
+
+        /**
+         * @brief smallest unsigned type that can hold the index of any state
+         */
+        using index_type = _index_type<T_State_List::size>;
+
+        /**
+         * @brief index of the initial state in the state list
+         */
+        static constexpr index_type init_state = index_of<T_State_Init, T_State_List>;
+
+        CoroutineFSM(const CoroutineFSM&) = delete;
+        CoroutineFSM& operator=(const CoroutineFSM&) = delete;
+
+        /**
+         * @brief starts the FSM
+         * @tparam T_State_Init_Start initial state of the FSM, has to match T_State_Init
+         * @tparam T_Arg argument types for the FSM constructor
+         * @param args arguments for the FSM constructor
+         */
+        template<class T_State_Init_Start = T_State_Init, typename... T_Arg>
+        static T_FSM_Child start(T_Arg... args)
+        {
+            static_assert(
+                std::is_same_v<T_State_Init_Start, T_State_Init>, "initial state is fixed"
+            );
+            return T_FSM_Child {args...};
+        }
+
+        /**
+         * @brief reacts to a given event
+         * @tparam T_Event event class to react to
+         * @param event event to react to
+         */
+        template<class T_Event>
+        inline void react(const T_Event& event)
+        {
+            if(reacting_) {
+                // raised by the protocol itself, which can only be resumed once it suspended
+                if(queue_ == nullptr) {
+                    queue_ = std::make_unique<_rtc_queue>();
+                }
+                queue_->push(&dispatch<T_Event>, event);
+                return;
+            }
+            const Reacting reacting {this};
+            resume(event);
+            if(queue_ != nullptr) {
+                queue_->run(this);
+            }
+        }
+
+        /**
+         * @brief resets the FSM, the protocol is restarted by the next event
+         * @note must not be called from the protocol itself
+         */
+        void reset()
+        {
+            protocol_ = Coroutine {};
+            state_ = init_state;
+            static_cast<T_FSM_Child*>(this)->resetter();
+        }
+
+        /**
+         * @brief checks if the FSM is in a given state
+         * @tparam state to check for
+         * @return bool that is true if FSM is in given state
+         */
+        template<class T_State>
+        inline bool is_in_state() const
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            return state_ == index_of<T_State, state_list>;
+        }
+
+        /**
+         * @brief index of the current state in the state list
+         */
+        inline index_type state_id() const
+        {
+            return state_;
+        }
+
+        /**
+         * @brief checks if the protocol ran to its end
+         */
+        inline bool done() const
+        {
+            return protocol_.done();
+        }
+
+        /**
+         * @brief pool the coroutine frame is allocated from, nullptr for the global heap
+         */
+        inline FramePool* frame_pool() const
+        {
+            return pool_;
+        }
+
+      protected:
+
+        /**
+         * @brief FSM constructor
+         * @param pool pool for the coroutine frame, nullptr for the global heap
+         */
+        CoroutineFSM(FramePool* const pool = nullptr)
+          : pool_(pool) {};
+
+        /**
+         * @brief sets the current state label
+         * @tparam T_State state to label the FSM with
+         */
+        template<class T_State>
+        inline void set_state()
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            state_ = index_of<T_State, state_list>;
+        }
+
+        /**
+         * @brief awaits the next event of one of the given types
+         * @tparam T_Events event types to wait for
+         * @return the event for a single type, otherwise a `Received` holding the event
+         */
+        template<class... T_Events>
+        static inline _next_awaiter<T_Events...> next()
+        {
+            return {};
+        }
+
+        /**
+         * @brief function called on reset
+         */
+        void resetter() {};
+
+      private:
+
+        /**
+         * \internal
+         * @brief resumes the protocol if it awaits the type of the event
+         */
+        template<class T_Event>
+        void resume(const T_Event& event)
+        {
+            if(!protocol_.started()) [[unlikely]] {
+                // runs up to the first co_await
+                protocol_ = static_cast<T_FSM_Child*>(this)->protocol();
+                protocol_._handle().resume();
+            }
+            const auto handle = protocol_._handle();
+            if(handle.done()) [[unlikely]] {
+                return;
+            }
+            auto& promise = handle.promise();
+            for(std::size_t key = 0; key < promise.n_keys; ++key) {
+                if(promise.keys[key] == &_event_key<T_Event>) {
+                    promise.event = &event;
+                    promise.matched = key;
+                    handle.resume();
+                    return;
+                }
+            }
+        }
+
+        /**
+         * \internal
+         * @brief reacts to a queued event, used by the run-to-completion queue
+         */
+        template<class T_Event>
+        static void dispatch(void* const fsm, const void* const event)
+        {
+            static_cast<CoroutineFSM*>(fsm)->resume(*static_cast<const T_Event*>(event));
+        }
+
+        /**
+         * \internal
+         * @brief marks the FSM as reacting while in scope
+         */
+        struct Reacting {
+            Reacting(CoroutineFSM* const _fsm)
+              : fsm(_fsm)
+            {
+                fsm->reacting_ = true;
+            };
+            ~Reacting()
+            {
+                fsm->reacting_ = false;
+                if(fsm->queue_ != nullptr) {
+                    // only not empty if the reaction threw
+                    fsm->queue_->clear();
+                }
+            };
+            CoroutineFSM* fsm;
+        };
+
+        Coroutine protocol_ {};
+        FramePool* pool_;
+
+        /**
+         * \internal
+         * @brief events raised by the protocol, only allocated once it raises one
+         */
+        std::unique_ptr<_rtc_queue> queue_ {};
+
+        index_type state_ {init_state};
+        bool reacting_ {false};
+    };
+
+}  // namespace scriptsizefsm
@@ -0,0 +1,297 @@
+/**
+ * @file
+ * @brief Counters of the reactions, transitions and fall-throughs per state and event
+ *
+ * `CountingTracer` is a tracing policy for `VariantFSM` and `CompactFSM` that counts for every
+ * pair of state and event how often the state reacted to the event, how often this caused a
+ * transition and how often the event fell through to the generic state. The counters are kept
+ * in a `CounterMatrix` with one cache line aligned shard per thread, laid out from the state and
+ * event lists, so counting is a plain increment without hashing or atomic read-modify-write.
+ * Reading sums up the shards of all threads.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * \internal
+     * @brief source of ids that identify counter matrices in the thread-local shard caches, never
+     * reused
+     */
+    inline std::atomic<std::uint64_t> _counter_matrix_ids {0};
+
+    /**
+     * @brief counters of all pairs of state and event of a FSM
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_Event_List `EventList` of the counted events, other events share one column
+     *
+     * Each thread counts into its own shard, which is created on its first count and kept until
+     * the matrix is destroyed. A thread started after another one finished can continue the shard
+     * of the finished thread if it gets the same thread id. Many FSMs can share a matrix.
+     */
+    template<class T_State_List, class T_Event_List>
+    class CounterMatrix {
+
+      public:
+
+        /**
+         * @brief number of columns, one per event and one for events not in the event list
+         */
+        static constexpr std::size_t n_columns = T_Event_List::size + 1;
+
+        /**
+         * @brief column of the events not in the event list
+         */
+        static constexpr std::size_t other_events = T_Event_List::size;
+
+        /**
+         * @brief what is counted
+         */
+        enum Counter : std::size_t
+        {
+            reactions,
+            transitions,
+            fell_through,
+            n_counters,
+        };
+
+        /**
+         * @brief counters of a pair of state and event, summed over all threads
+         */
+        struct Counts {
+            /**
+             * @brief number of reactions of the state to the event
+             */
+            std::uint64_t reactions;
+
+            /**
+             * @brief number of reactions that caused a transition
+             */
+            std::uint64_t transitions;
+
+            /**
+             * @brief number of reactions the generic state handled, since the state has none
+             */
+            std::uint64_t fell_through;
+
+            /**
+             * @brief number of reactions handled by the state itself
+             */
+            inline std::uint64_t handled() const
+            {
+                return reactions - fell_through;
+            }
+        };
+
+        CounterMatrix() = default;
+        CounterMatrix(const CounterMatrix&) = delete;
+        CounterMatrix& operator=(const CounterMatrix&) = delete;
+
+        /**
+         * @brief increments a counter in the shard of the calling thread
+         * @param state index of the state in the state list
+         * @param column index of the event in the event list, or `other_events`
+         * @param counter counter to increment
+         */
+        inline void count(std::size_t state, std::size_t column, Counter counter)
+        {
+            auto& value = shard().counts[(state * n_columns + column) * n_counters + counter];
+            value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief counters of a pair of state and event, summed over all threads
+         * @param state index of the state in the state list
+         * @param column index of the event in the event list, or `other_events`
+         */
+        Counts counts(std::size_t state, std::size_t column) const
+        {
+            const std::size_t cell = (state * n_columns + column) * n_counters;
+            std::array<std::uint64_t, n_counters> sums {};
+            const std::lock_guard<std::mutex> lock {mutex_};
+            for(const auto& shard : shards_) {
+                for(std::size_t counter = 0; counter < n_counters; ++counter) {
+                    sums[counter] += shard->counts[cell + counter].load(std::memory_order_relaxed);
+                }
+            }
+            return Counts {sums[reactions], sums[transitions], sums[fell_through]};
+        }
+
+        /**
+         * @brief counters of a given state and event, summed over all threads
+         */
+        template<class T_State, class T_Event>
+        Counts get() const
+        {
+            static_assert(_index_of<T_State, T_State_List>::found, "state not in state list");
+            return counts(index_of<T_State, T_State_List>, column<T_Event>());
+        }
+
+        /**
+         * @brief column of an event, `other_events` if it is not in the event list
+         */
+        template<class T_Event>
+        static constexpr std::size_t column()
+        {
+            return _index_of<T_Event, T_Event_List>::value;
+        }
+
+        /**
+         * @brief number of threads that counted so far
+         */
+        std::size_t shards() const
+        {
+            const std::lock_guard<std::mutex> lock {mutex_};
+            return shards_.size();
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief counters of one thread, written only by that thread
+         */
+        struct alignas(_cache_line) Shard {
+            std::array<std::atomic<std::uint64_t>, T_State_List::size * n_columns * n_counters>
+                counts {};
+            std::thread::id owner {std::this_thread::get_id()};
+        };
+
+        /**
+         * \internal
+         * @brief shard of the thread in a matrix, cached per thread for all matrices of a type
+         *
+         * The cache is direct-mapped by the id of the matrix, so a thread alternating between a
+         * few matrices hits it for each of them. Entries of destroyed matrices are never hit
+         * again, since ids are not reused, and are overwritten by later matrices.
+         */
+        struct Cache {
+            std::uint64_t id {0};
+            Shard* shard {nullptr};
+        };
+
+        static constexpr std::size_t cache_size = 16;
+
+        inline Shard& shard()
+        {
+            static thread_local std::array<Cache, cache_size> caches {};
+            Cache& cache = caches[id_ % cache_size];
+            if(cache.id != id_) {
+                cache.shard = add_shard();
+                cache.id = id_;
+            }
+            return *cache.shard;
+        }
+
+        /**
+         * \internal
+         * @brief finds or creates the shard of the calling thread
+         *
+         * Only called when the cache misses, the shards are looked up in the matrix, so no thread
+         * keeps entries of destroyed matrices.
+         */
+        Shard* add_shard()
+        {
+            const auto thread = std::this_thread::get_id();
+            const std::lock_guard<std::mutex> lock {mutex_};
+            for(const auto& shard : shards_) {
+                if(shard->owner == thread) {
+                    return shard.get();
+                }
+            }
+            shards_.emplace_back(new Shard());
+            return shards_.back().get();
+        }
+
+        /**
+         * \internal
+         * @brief unique id of the matrix, so that a new matrix at the address of a destroyed one
+         * does not reuse stale shards
+         */
+        const std::uint64_t id_ {_counter_matrix_ids.fetch_add(1, std::memory_order_relaxed) + 1};
+        mutable std::mutex mutex_ {};
+        std::vector<std::unique_ptr<Shard>> shards_ {};
+    };
+
+    /**
+     * @brief tracing policy counting reactions, transitions and fall-throughs in a `CounterMatrix`
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_Event_List `EventList` of the counted events
+     *
+     * Transitions are counted for the state that is left and the event of the reaction they happen
+     * in. Only works with the FSMs that identify states by index, i.e. not with `FSM`.
+     */
+    template<class T_State_List, class T_Event_List>
+    class CountingTracer : public NoTracer {
+
+      public:
+
+        /**
+         * @brief matrix the tracer counts into
+         */
+        using matrix_type = CounterMatrix<T_State_List, T_Event_List>;
+
+        /**
+         * @brief starts counting into a matrix
+         */
+        inline void attach(matrix_type& matrix)
+        {
+            matrix_ = &matrix;
+        }
+
+        /**
+         * @brief stops counting
+         */
+        inline void detach()
+        {
+            matrix_ = nullptr;
+        }
+
+        template<class T_FSM, class T_State_Id, class T_Event>
+        inline void on_react(const T_FSM& fsm, T_State_Id state, const T_Event& event)
+        {
+            column_ = matrix_type::template column<T_Event>();
+            count(state, matrix_type::reactions);
+        }
+
+        template<class T_FSM, class T_State_Id, class T_Event>
+        inline void on_unhandled(const T_FSM& fsm, T_State_Id state, const T_Event& event)
+        {
+            count(state, matrix_type::fell_through);
+        }
+
+        template<class T_FSM, class T_State_Id>
+        inline void on_transit(const T_FSM& fsm, T_State_Id from, T_State_Id to)
+        {
+            count(from, matrix_type::transitions);
+        }
+
+      private:
+
+        inline void count(std::size_t state, typename matrix_type::Counter counter)
+        {
+            if(matrix_ != nullptr) {
+                matrix_->count(state, column_, counter);
+            }
+        }
+
+        matrix_type* matrix_ {nullptr};
+        std::size_t column_ {matrix_type::other_events};
+    };
+
+}  // namespace scriptsizefsm
@@ -0,0 +1,210 @@
+/**
+ * @file
+ * @brief Executor running many mailbox-driven FSMs as actors on a thread pool
+ *
+ * Each FSM owned by an `Executor` derives from `Mailbox`. Posting an event to an idle FSM
+ * schedules it once on the `ThreadPool`, so workers only ever see FSMs with pending events and
+ * idle FSMs cost nothing. A scheduled FSM drains at most a fixed batch of events per activation
+ * and is scheduled again if events are left, so a single busy FSM can not starve the others.
+ * Since an FSM is scheduled at most once at a time, its reactions never run concurrently.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <utility>
+
+#include "scriptsizefsm/mailbox.hpp"
+#include "scriptsizefsm/parallel.hpp"
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * @brief runs FSMs with a mailbox as actors on a thread pool
+     * @tparam T_FSM FSM implementation, has to derive from `Mailbox<T_FSM, ...>`
+     *
+     * FSMs are started with `spawn` and identified by their index. Spawning is not thread-safe
+     * and must not happen concurrently with `post`, posting is safe from any thread, including
+     * from reactions running on the pool.
+     */
+    template<class T_FSM>
+    class Executor {
+
+      public:
+
+        /**
+         * @brief executor constructor
+         * @param pool thread pool to run the FSMs on
+         * @param batch_size maximum number of events drained per activation of a FSM
+         */
+        explicit Executor(ThreadPool& pool, std::size_t batch_size = 64)
+          : pool_(pool),
+            batch_size_(std::max<std::size_t>(batch_size, 1)) {};
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        /**
+         * @brief finishes all pending events before destroying the FSMs
+         */
+        ~Executor()
+        {
+            wait();
+        };
+
+        /**
+         * @brief starts a new FSM owned by the executor
+         * @tparam T_State_Init initial state of the FSM
+         * @tparam T_Arg argument types for the FSM constructor
+         * @param args arguments for the FSM constructor
+         * @return id of the FSM
+         */
+        template<class T_State_Init, typename... T_Arg>
+        std::size_t spawn(T_Arg... args)
+        {
+            actors_.emplace_back(_type_tag<T_State_Init> {}, args...);
+            return actors_.size() - 1;
+        }
+
+        /**
+         * @brief posts an event to a FSM and schedules it if it was idle
+         * @param id id of the FSM
+         * @param event event to copy or move into the mailbox of the FSM
+         * @return false if the mailbox is full and the event was dropped
+         */
+        template<class T_Event>
+        bool post(std::size_t id, T_Event&& event)
+        {
+            Actor& actor = actors_[id];
+            // counted before posting, so that a running activation never drains more events than
+            // are counted
+            const std::size_t pending = actor.pending.fetch_add(1, std::memory_order_acq_rel);
+            if(!actor.fsm.post(std::forward<T_Event>(event))) {
+                actor.pending.fetch_sub(1, std::memory_order_acq_rel);
+                return false;
+            }
+            if(pending == 0) {
+                schedule(actor);
+            }
+            return true;
+        }
+
+        /**
+         * @brief waits until all posted events are processed
+         *
+         * Only the activations of this executor are waited for, not other tasks on the pool. Do
+         * not call this function from within a reaction, see `ThreadPool::wait`.
+         */
+        inline void wait()
+        {
+            pool_.wait(activations_);
+        }
+
+        /**
+         * @brief number of FSMs
+         */
+        inline std::size_t size() const
+        {
+            return actors_.size();
+        }
+
+        /**
+         * @brief maximum number of events drained per activation of a FSM
+         */
+        inline std::size_t batch_size() const
+        {
+            return batch_size_;
+        }
+
+        /**
+         * @brief access to a FSM, only safe while no events are pending, e.g. after `wait`
+         * @param id id of the FSM
+         */
+        inline T_FSM& operator[](std::size_t id)
+        {
+            return actors_[id].fsm;
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief FSM with its number of pending events, padded to avoid false sharing between FSMs
+         */
+        struct alignas(_cache_line) Actor {
+            template<class T_State_Init, typename... T_Arg>
+            Actor(_type_tag<T_State_Init> /*tag*/, T_Arg... args)
+              : fsm(start<T_FSM, T_State_Init>(args...))
+            {}
+
+            /**
+             * \internal
+             * @brief number of posted events that are not drained yet
+             *
+             * The FSM is scheduled exactly while this is not zero, the post that raises it from
+             * zero schedules the FSM.
+             */
+            std::atomic<std::size_t> pending {0};
+
+            /**
+             * \internal
+             * @brief the FSM
+             */
+            T_FSM fsm;
+        };
+
+        /**
+         * \internal
+         * @brief submits an activation of a FSM to the pool
+         */
+        inline void schedule(Actor& actor)
+        {
+            pool_.submit([this, &actor]() { activate(actor); }, activations_);
+        }
+
+        /**
+         * \internal
+         * @brief drains a batch of events and schedules the FSM again if events are left
+         */
+        void activate(Actor& actor)
+        {
+            const std::size_t drained = actor.fsm.drain(batch_size_);
+            if(actor.pending.fetch_sub(drained, std::memory_order_acq_rel) != drained) {
+                // submitted to the queue of this worker, other workers can steal it
+                schedule(actor);
+            }
+        }
+
+        /**
+         * \internal
+         * @brief thread pool the FSMs run on
+         */
+        ThreadPool& pool_;
+
+        /**
+         * \internal
+         * @brief maximum number of events drained per activation
+         */
+        std::size_t batch_size_;
+
+        /**
+         * \internal
+         * @brief FSMs, a deque keeps their addresses stable when spawning
+         */
+        std::deque<Actor> actors_;
+
+        /**
+         * \internal
+         * @brief latch counting the scheduled activations of the FSMs
+         */
+        ThreadPool::Latch activations_ {};
+    };
+
+}  // namespace scriptsizefsm
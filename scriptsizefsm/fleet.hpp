@@ -0,0 +1,496 @@
+/**
+ * @file
+ * @brief Structure-of-arrays container for many instances of the same FSM
+ *
+ * A `Fleet` stores the current state of all its FSMs in one dense array and the data of the FSMs
+ * in parallel columns. The FSM implementation derives from `FleetFSM`, which is a lightweight
+ * handle to one row of the fleet and offers the same `react`, `transit`, `reset` and
+ * `is_in_state` API as the other FSMs. Events can be sent to all FSMs of a fleet at once, which
+ * results in a tight loop over the state array.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    template<class T_FSM>
+    class Fleet;
+
+    /**
+     * \internal
+     * @brief storage of the current state index in the state column of a fleet
+     */
+    template<class T_FSM, class T_Index>
+    class _fleet_storage {
+
+      protected:
+
+        _fleet_storage(Fleet<T_FSM>* const fleet, std::size_t id)
+          : fleet_(fleet),
+            id_(id) {};
+
+        inline T_Index& current_state()
+        {
+            return fleet_->states_[id_];
+        }
+
+        inline const T_Index& current_state() const
+        {
+            return fleet_->states_[id_];
+        }
+
+        /**
+         * \internal
+         * @brief fleet the FSM is stored in
+         */
+        Fleet<T_FSM>* fleet_;
+
+        /**
+         * \internal
+         * @brief id of the FSM in the fleet
+         */
+        std::size_t id_;
+    };
+
+    /**
+     * @brief Finite State Machine class stored in a Fleet
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_State_Generic class of the generic state containing all reactions
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_State_Init initial state of the FSM
+     * @tparam T_Columns types of the data columns of the FSM
+     *
+     * The FSM implementation is a handle to a row of a fleet and can not contain member variables.
+     * Instead, the data of the FSM is stored in columns, accessed with `column<T_Column>()`.
+     */
+    template<
+        class T_FSM_Child,
+        class T_State_Generic,
+        class T_State_List,
+        class T_State_Init,
+        class... T_Columns>
+    class FleetFSM
+      : public _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _fleet_storage<T_FSM_Child, _index_type<T_State_List::size>>> {
+
+        using _base = _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _fleet_storage<T_FSM_Child, _index_type<T_State_List::size>>>;
+
+        friend Fleet<T_FSM_Child>;
+
+      public:
+
+        using typename _base::index_type;
+        using typename _base::state_list;
+
+        /**
+         * @brief list of the data column types
+         */
+        using column_list = TypeList<T_Columns...>;
+
+        static_assert(_index_of<T_State_Init, T_State_List>::found, "state not in state list");
+        static_assert(_history_count(T_State_List {}) == 0, "history is not stored in fleets");
+
+        /**
+         * @brief index of the initial state, or of the state entered with it if it has children
+         */
+        static constexpr index_type init_state =
+            index_of<typename _target_of<T_State_Init>::type, T_State_List>;
+
+        /**
+         * @brief resets the FSM
+         *
+         * This function exits the current state and enters the initial state.
+         */
+        void reset()
+        {
+            this->run_to_completion([this]() {
+                this->exit_current();
+                this->current_state() = init_state;
+                static_cast<T_FSM_Child*>(this)->resetter();
+                this->entry_current();
+            });
+        };
+
+        /**
+         * @brief id of the FSM in its fleet
+         */
+        inline std::size_t id() const
+        {
+            return this->id_;
+        }
+
+      protected:
+
+        /**
+         * @brief FSM constructor
+         * @param fleet fleet the FSM is stored in
+         * @param id id of the FSM in the fleet
+         */
+        FleetFSM(Fleet<T_FSM_Child>* const fleet, std::size_t id)
+          : _base(fleet, id) {};
+
+        /**
+         * @brief access the data of the FSM in a column
+         * @tparam T_Column type of the column
+         * @return reference to the data of the FSM
+         */
+        template<class T_Column>
+        inline T_Column& column()
+        {
+            return this->fleet_->template column<T_Column>()[this->id_];
+        }
+
+        /**
+         * @brief additional function called on reset
+         *
+         * Hide this function in the FSM implementation to run code on reset.
+         */
+        void resetter() {};
+    };
+
+    /**
+     * @brief container for many instances of a FleetFSM
+     * @tparam T_FSM FSM implementation derived from `FleetFSM`
+     *
+     * The FSMs are identified by their id, which is the index of their row. The current states of
+     * all FSMs are stored in a single array, the data of the FSMs in one array per column.
+     */
+    template<class T_FSM>
+    class Fleet {
+
+        template<class, class>
+        friend class _fleet_storage;
+
+      public:
+
+        /**
+         * @brief type of the state index
+         */
+        using index_type = typename T_FSM::index_type;
+
+        /**
+         * @brief list of all states of the FSMs
+         */
+        using state_list = typename T_FSM::state_list;
+
+        /**
+         * @brief adds a FSM to the fleet
+         * @tparam T_State_Init initial state of the FSM, has to match the one of T_FSM
+         * @tparam T_Column_Arg argument types for the data columns
+         * @param args initial value for each data column
+         * @return id of the new FSM
+         */
+        template<class T_State_Init = void, typename... T_Column_Arg>
+        std::size_t add(T_Column_Arg&&... args)
+        {
+            static_assert(
+                std::is_void_v<T_State_Init> ||
+                    index_of<typename _target_of<T_State_Init>::type, state_list> ==
+                        T_FSM::init_state,
+                "initial state is fixed"
+            );
+            states_.push_back(T_FSM::init_state);
+            static_assert(
+                sizeof...(T_Column_Arg) == T_FSM::column_list::size, "one value per column required"
+            );
+            add_columns(
+                std::index_sequence_for<T_Column_Arg...> {}, std::forward<T_Column_Arg>(args)...
+            );
+            return states_.size() - 1;
+        }
+
+        /**
+         * @brief reserves memory for a number of FSMs
+         * @param size number of FSMs
+         */
+        void reserve(std::size_t size)
+        {
+            states_.reserve(size);
+            std::apply([size](auto&... columns) { (columns.reserve(size), ...); }, columns_);
+        }
+
+        /**
+         * @brief number of FSMs in the fleet
+         */
+        inline std::size_t size() const
+        {
+            return states_.size();
+        }
+
+        /**
+         * @brief handle to a FSM in the fleet
+         * @param id id of the FSM
+         * @return FSM handle referring to the row of the FSM
+         */
+        inline T_FSM operator[](std::size_t id)
+        {
+            return T_FSM {{this, id}};
+        }
+
+        /**
+         * @brief lets a single FSM react to an event
+         * @param id id of the FSM
+         * @param event event to react to
+         */
+        template<class T_Event>
+        inline void react(std::size_t id, const T_Event& event)
+        {
+            (*this)[id].react(event);
+        }
+
+        /**
+         * @brief lets all FSMs react to an event
+         * @param event event to react to
+         */
+        template<class T_Event>
+        void broadcast(const T_Event& event)
+        {
+            _rtc_context batch {nullptr};
+            const std::size_t size = states_.size();
+            for(std::size_t id = 0; id < size; ++id) {
+                T_FSM {{this, id}}._react_batched(batch, event);
+            }
+        }
+
+        /**
+         * @brief lets a number of FSMs react to one event each
+         * @param ids container with the ids of the FSMs
+         * @param events container with the event for each FSM, same size as ids
+         */
+        template<class T_Ids, class T_Events>
+        void dispatch(const T_Ids& ids, const T_Events& events)
+        {
+            _rtc_context batch {nullptr};
+            auto event = std::begin(events);
+            for(const auto id : ids) {
+                T_FSM {{this, static_cast<std::size_t>(id)}}._react_batched(batch, *event);
+                ++event;
+            }
+        }
+
+        /**
+         * @brief checks if a FSM is in a given state
+         * @tparam T_State state to check for
+         * @param id id of the FSM
+         */
+        template<class T_State>
+        inline bool is_in_state(std::size_t id) const
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            return states_[id] == index_of<T_State, state_list>;
+        }
+
+        /**
+         * @brief counts the FSMs in a given state
+         * @tparam T_State state to count
+         */
+        template<class T_State>
+        std::size_t count() const
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            std::size_t count = 0;
+            for(const auto state : states_) {
+                count += state == index_of<T_State, state_list> ? 1 : 0;
+            }
+            return count;
+        }
+
+        /**
+         * @brief resets a FSM
+         * @param id id of the FSM
+         */
+        inline void reset(std::size_t id)
+        {
+            (*this)[id].reset();
+        }
+
+        /**
+         * @brief state column of the fleet
+         * @return pointer to the state index of the first FSM
+         */
+        inline index_type* states()
+        {
+            return states_.data();
+        }
+
+        /**
+         * @brief data column of the fleet
+         * @tparam T_Column type of the column
+         * @return pointer to the data of the first FSM
+         */
+        template<class T_Column>
+        inline T_Column* column()
+        {
+            return std::get<std::vector<T_Column>>(columns_).data();
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief appends a value to each data column
+         */
+        template<std::size_t... I, typename... T_Column_Arg>
+        void add_columns(std::index_sequence<I...>, T_Column_Arg&&... args)
+        {
+            (std::get<I>(columns_).emplace_back(std::forward<T_Column_Arg>(args)), ...);
+        }
+
+        /**
+         * \internal
+         * @brief helper to get the column vectors from the column types
+         */
+        template<class... T_Columns>
+        static std::tuple<std::vector<T_Columns>...> column_storage(TypeList<T_Columns...>);
+
+        /**
+         * \internal
+         * @brief state column
+         */
+        std::vector<index_type> states_;
+
+        /**
+         * \internal
+         * @brief data columns
+         */
+        decltype(column_storage(typename T_FSM::column_list {})) columns_;
+    };
+
+    /// @{
+    /**
+     * \internal
+     * @brief detects states with a specialized batch reaction
+     */
+    template<class T_State, class T_FSM, class T_Event, class = void>
+    struct _has_react_batch : std::false_type {};
+
+    template<class T_State, class T_FSM, class T_Event>
+    struct _has_react_batch<
+        T_State,
+        T_FSM,
+        T_Event,
+        std::void_t<decltype(std::declval<const T_State&>().react_batch(
+            std::declval<T_FSM* const*>(), std::size_t {}, std::declval<const T_Event&>()
+        ))>> : std::true_type {};
+    /// @}
+
+    /**
+     * \internal
+     * @brief lets all FSMs of a bucket react to an event, knowing their state
+     */
+    template<class T_State, class T_FSM, class T_Event>
+    inline void _react_bucket(
+        _rtc_context& batch,
+        T_FSM* const* fsms,
+        std::size_t count,
+        const T_Event& event
+    )
+    {
+        if constexpr(_has_react_batch<T_State, T_FSM, T_Event>::value) {
+            _state_instance<T_State>::value.react_batch(fsms, count, event);
+        } else {
+            for(std::size_t index = 0; index < count; ++index) {
+                fsms[index]->template _react_in<T_State>(batch, event);
+            }
+        }
+    }
+
+    /**
+     * @brief lets many FSMs react to an event, grouped by their current state
+     * @tparam T_FSM FSM implementation with a state list, e.g. derived from `CompactFSM`
+     * @tparam T_Event event class to react to
+     * @param fsms pointer to the first FSM
+     * @param count number of FSMs
+     * @param event event to react to
+     * @param scratch array of at least `count` pointers, used to sort the FSMs into buckets
+     *
+     * The FSMs are first sorted into buckets by their current state, then the reaction of each
+     * state is called for all FSMs in its bucket. This keeps the branch predictor and the
+     * instruction cache hot. A state can further specialize the reaction of a whole bucket by
+     * providing `react_batch(T_FSM* const* fsms, std::size_t count, const T_Event& event) const`.
+     * Each FSM reacts exactly once, also if it changes its state during the reaction.
+     */
+    template<class T_FSM, class T_Event>
+    void react_batch(T_FSM* const fsms, std::size_t count, const T_Event& event, T_FSM** scratch)
+    {
+        using state_list = typename T_FSM::state_list;
+
+        // count FSMs per state
+        std::array<std::size_t, state_list::size + 1> offsets {};
+        for(std::size_t index = 0; index < count; ++index) {
+            ++offsets[fsms[index].state_id() + 1U];
+        }
+        for(std::size_t state = 1; state <= state_list::size; ++state) {
+            offsets[state] += offsets[state - 1];
+        }
+
+        // sort FSMs into buckets
+        auto positions = offsets;
+        for(std::size_t index = 0; index < count; ++index) {
+            scratch[positions[fsms[index].state_id()]++] = &fsms[index];
+        }
+
+        // react bucket by bucket, all in one run-to-completion context
+        _rtc_context batch {nullptr};
+        _for_each_index<state_list>([&](auto tag, std::size_t state) {
+            using state_type = typename decltype(tag)::type;
+            const auto size = offsets[state + 1] - offsets[state];
+            if(size > 0) {
+                _react_bucket<state_type>(batch, scratch + offsets[state], size, event);
+            }
+        });
+    }
+
+    /**
+     * @brief lets many FSMs react to an event, grouped by their current state
+     * @param fsms pointer to the first FSM
+     * @param count number of FSMs
+     * @param event event to react to
+     *
+     * The buckets are sorted in a buffer kept per thread, which only allocates when it grows. The
+     * buffer is taken out while in use, so batches started from a reaction get their own.
+     */
+    template<class T_FSM, class T_Event>
+    void react_batch(T_FSM* const fsms, std::size_t count, const T_Event& event)
+    {
+        thread_local std::vector<T_FSM*> scratch {};
+        std::vector<T_FSM*> buckets = std::move(scratch);
+        if(buckets.size() < count) {
+            buckets.resize(count);
+        }
+        react_batch(fsms, count, event, buckets.data());
+        scratch = std::move(buckets);
+    }
+
+    /**
+     * @brief lets all FSMs in a container react to an event, grouped by their current state
+     * @param fsms contiguous container of FSMs, e.g. a `std::vector`
+     * @param event event to react to
+     */
+    template<class T_Container, class T_Event>
+    inline void react_batch(T_Container& fsms, const T_Event& event)
+    {
+        react_batch(std::data(fsms), std::size(fsms), event);
+    }
+
+}  // namespace scriptsizefsm
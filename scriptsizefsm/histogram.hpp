@@ -0,0 +1,412 @@
+/**
+ * @file
+ * @brief Per-state dwell time histograms
+ *
+ * `DwellTracer` is a tracing policy for `VariantFSM` and `CompactFSM` that timestamps sampled or
+ * all transitions and records how long the FSM stayed in the state it leaves. The dwell times are
+ * collected in lock-free log-linear histograms, one per state. The histograms are written by one
+ * thread, e.g. shared by all FSMs running on it, can be read by other threads while the FSMs keep
+ * running and are merged to combine the histograms of several threads.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define SCRIPTSIZEFSM_HAS_TSC
+#elif defined(__linux__)
+#include <time.h>
+#endif
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * @brief reads a cheap monotonic timestamp
+     *
+     * The time stamp counter on x86, `CLOCK_MONOTONIC_RAW` in nanoseconds on other Linux systems
+     * and the steady clock otherwise. Timestamps taken on different cores are only comparable if
+     * the time stamp counter is invariant, which is the case for all recent x86 CPUs.
+     */
+    inline std::uint64_t timestamp()
+    {
+#if defined(SCRIPTSIZEFSM_HAS_TSC)
+        return __rdtsc();
+#elif defined(__linux__)
+        timespec time {};
+        clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+        return static_cast<std::uint64_t>(time.tv_sec) * 1000000000U +
+               static_cast<std::uint64_t>(time.tv_nsec);
+#else
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()
+        );
+#endif
+    }
+
+    /**
+     * @brief number of `timestamp` ticks per second
+     *
+     * For the time stamp counter the frequency is measured against the steady clock on the first
+     * call, which takes about 10 ms.
+     */
+    inline double timestamp_frequency()
+    {
+#if defined(SCRIPTSIZEFSM_HAS_TSC)
+        static const double frequency = []() {
+            const auto begin = std::chrono::steady_clock::now();
+            const std::uint64_t begin_ticks = timestamp();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const std::uint64_t end_ticks = timestamp();
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - begin;
+            return static_cast<double>(end_ticks - begin_ticks) / duration.count();
+        }();
+        return frequency;
+#else
+        return 1e9;
+#endif
+    }
+
+    /**
+     * @brief lock-free log-linear histogram of 64 bit values
+     *
+     * Values below 8 have a bucket each, larger values are split into 8 buckets per power of
+     * two, so the relative error of a bucket is at most 12.5 %. Only one thread may record values,
+     * since the counts are incremented without atomic read-modify-write, but any thread can read
+     * or merge the histogram at any time.
+     */
+    class Histogram {
+
+      public:
+
+        /**
+         * @brief number of bits of a value below its highest bit that select the bucket
+         */
+        static constexpr unsigned int sub_bucket_bits = 3;
+
+        /**
+         * @brief number of buckets per power of two
+         */
+        static constexpr std::size_t sub_buckets = std::size_t {1} << sub_bucket_bits;
+
+        /**
+         * @brief number of buckets covering all 64 bit values
+         */
+        static constexpr std::size_t buckets = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+        Histogram() = default;
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+        /**
+         * @brief bucket a value is counted in
+         */
+        static inline std::size_t bucket(std::uint64_t value)
+        {
+            if(value < sub_buckets) {
+                return static_cast<std::size_t>(value);
+            }
+            const unsigned int shift = _highest_bit(value) - sub_bucket_bits;
+            return (shift + 1) * sub_buckets +
+                   static_cast<std::size_t>((value >> shift) & (sub_buckets - 1));
+        }
+
+        /**
+         * @brief smallest value counted in a bucket
+         */
+        static inline std::uint64_t lower_bound(std::size_t bucket)
+        {
+            if(bucket < sub_buckets) {
+                return bucket;
+            }
+            const std::size_t shift = bucket / sub_buckets - 1;
+            return (sub_buckets + bucket % sub_buckets) << shift;
+        }
+
+        /**
+         * @brief largest value counted in a bucket
+         */
+        static inline std::uint64_t upper_bound(std::size_t bucket)
+        {
+            if(bucket < sub_buckets) {
+                return bucket;
+            }
+            const std::size_t shift = bucket / sub_buckets - 1;
+            return lower_bound(bucket) + ((std::uint64_t {1} << shift) - 1);
+        }
+
+        /**
+         * @brief counts a value
+         */
+        inline void record(std::uint64_t value)
+        {
+            auto& count = counts_[bucket(value)];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief number of values counted in a bucket
+         */
+        inline std::uint64_t count(std::size_t bucket) const
+        {
+            return counts_[bucket].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief number of values counted in all buckets
+         */
+        std::uint64_t count() const
+        {
+            std::uint64_t total = 0;
+            for(const auto& count : counts_) {
+                total += count.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        /**
+         * @brief value below which a given fraction of the counted values lies
+         * @param fraction fraction between 0 and 1, e.g. 0.99 for the 99th percentile
+         * @return upper bound of the bucket containing the quantile, zero if nothing was counted
+         */
+        std::uint64_t quantile(double fraction) const
+        {
+            const std::uint64_t total = count();
+            if(total == 0) {
+                return 0;
+            }
+            auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+            rank = rank < 1 ? 1 : (rank > total ? total : rank);
+            std::uint64_t seen = 0;
+            std::size_t index = 0;
+            while(index + 1 < buckets && (seen += count(index)) < rank) {
+                ++index;
+            }
+            return upper_bound(index);
+        }
+
+        /**
+         * @brief adds the counts of another histogram to this one
+         *
+         * The other histogram may be recorded into concurrently, this one not, except by the
+         * thread calling this function.
+         */
+        void merge(const Histogram& other)
+        {
+            for(std::size_t index = 0; index < buckets; ++index) {
+                const std::uint64_t count = other.count(index);
+                if(count != 0) {
+                    counts_[index].fetch_add(count, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief sets all counts to zero, only from the thread recording into the histogram
+         */
+        void clear()
+        {
+            for(auto& count : counts_) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+      private:
+
+        std::array<std::atomic<std::uint64_t>, buckets> counts_ {};
+    };
+
+    /**
+     * @brief dwell time histograms of all states of a FSM, in `timestamp` ticks
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     */
+    template<class T_State_List>
+    class DwellHistograms {
+
+      public:
+
+        /**
+         * @brief list of all states of the FSM
+         */
+        using state_list = T_State_List;
+
+        /// @{
+        /**
+         * @brief histogram of the state with a given index
+         */
+        inline Histogram& operator[](std::size_t state_id)
+        {
+            return histograms_[state_id];
+        }
+
+        inline const Histogram& operator[](std::size_t state_id) const
+        {
+            return histograms_[state_id];
+        }
+        /// @}
+
+        /**
+         * @brief histogram of a given state
+         */
+        template<class T_State>
+        inline const Histogram& get() const
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            return histograms_[index_of<T_State, state_list>];
+        }
+
+        /**
+         * @brief adds the counts of the histograms of e.g. another thread
+         */
+        void merge(const DwellHistograms& other)
+        {
+            for(std::size_t state = 0; state < T_State_List::size; ++state) {
+                histograms_[state].merge(other.histograms_[state]);
+            }
+        }
+
+      private:
+
+        std::array<Histogram, T_State_List::size> histograms_ {};
+    };
+
+    /**
+     * @brief tracing policy recording the dwell time of each state
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam N_Sampling on average one in how many state visits is recorded, 1 records all
+     *
+     * Recording starts when the tracer is attached to histograms. Each transition and reset then
+     * takes a timestamp and counts the time since the previous one for the state that is left.
+     * Only works with the FSMs that identify states by index, i.e. not with `FSM`.
+     *
+     * Reading the clock dominates the cost of a transition. With sampling, the visit starting at
+     * the attachment is timed and the distance to the next timed visit is drawn uniformly from 1
+     * to `2 N_Sampling - 1` visits, so that FSMs cycling through their states in step with the
+     * sampling still have all states sampled. The histograms then count only the sampled visits.
+     */
+    template<class T_State_List, std::uint32_t N_Sampling = 8>
+    class DwellTracer : public NoTracer {
+
+        static_assert(N_Sampling > 0, "at least one in N_Sampling visits has to be recorded");
+
+      public:
+
+        /**
+         * @brief starts recording into the given histograms
+         */
+        inline void attach(DwellHistograms<T_State_List>& histograms)
+        {
+            histograms_ = &histograms;
+            entered_ = timestamp();
+            random_ = static_cast<std::uint32_t>((entered_ * 0x9E3779B97F4A7C15U) >> 32U) | 1U;
+            sampled_ = true;
+            countdown_ = gap();
+        }
+
+        /**
+         * @brief stops recording
+         */
+        inline void detach()
+        {
+            histograms_ = nullptr;
+        }
+
+        /**
+         * @brief timestamp of the last sampled transition, or of attaching
+         */
+        inline std::uint64_t entered() const
+        {
+            return entered_;
+        }
+
+        template<class T_FSM, class T_State_Id>
+        inline void on_transit(const T_FSM& fsm, T_State_Id from, T_State_Id to)
+        {
+            record(from);
+        }
+
+        template<class T_FSM>
+        inline void on_reset(const T_FSM& fsm)
+        {
+            record(fsm.state_id());
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief counts the time since entering for the state that is left, if its visit is sampled
+         */
+        inline void record(std::size_t state)
+        {
+            if(histograms_ == nullptr) {
+                return;
+            }
+            if constexpr(N_Sampling == 1) {
+                const std::uint64_t now = timestamp();
+                count(state, now);
+                entered_ = now;
+            } else {
+                const bool leaves_sampled = sampled_;
+                sampled_ = --countdown_ == 0;
+                if(leaves_sampled || sampled_) {
+                    const std::uint64_t now = timestamp();
+                    if(leaves_sampled) {
+                        count(state, now);
+                    }
+                    entered_ = now;
+                    if(sampled_) {
+                        countdown_ = gap();
+                    }
+                }
+            }
+        }
+
+        /**
+         * \internal
+         * @brief draws the number of visits until the next sampled one, from xorshift32
+         */
+        inline std::uint64_t gap()
+        {
+            random_ ^= random_ << 13U;
+            random_ ^= random_ >> 17U;
+            random_ ^= random_ << 5U;
+            return 1 + ((std::uint64_t {random_} * (2 * std::uint64_t {N_Sampling} - 1)) >> 32U);
+        }
+
+        /**
+         * \internal
+         * @brief counts the time between entering and leaving a state
+         */
+        inline void count(std::size_t state, std::uint64_t now)
+        {
+            // a counter that is not invariant can go backwards after a migration
+            (*histograms_)[state].record(now > entered_ ? now - entered_ : 0);
+        }
+
+        DwellHistograms<T_State_List>* histograms_ {nullptr};
+        std::uint64_t entered_ {0};
+
+        /**
+         * \internal
+         * @brief state of the sampling: visits until the next sampled one, the random number
+         * generator and whether the current visit is sampled
+         */
+        std::uint64_t countdown_ {0};
+        std::uint32_t random_ {1};
+        bool sampled_ {false};
+    };
+
+}  // namespace scriptsizefsm
@@ -0,0 +1,235 @@
+/**
+ * @file
+ * @brief Lock-free mailbox to post events to a FSM from other threads
+ *
+ * `react` is synchronous and not thread-safe. A FSM that additionally derives from `Mailbox` can
+ * receive events from any number of threads via `post`, while a single owner thread runs them to
+ * completion with `drain`. The mailbox is a bounded ring in the style of Dmitry Vyukov's queue,
+ * with the events stored in fixed-size inline slots, so posting never allocates and never blocks.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * @brief bounded multi-producer single-consumer event queue for a FSM
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam N_Capacity number of slots, has to be a power of two
+     * @tparam N_Slot_Size maximum size of a posted event in bytes
+     *
+     * The FSM implementation derives from its FSM base class and from `Mailbox`. Since the slots
+     * are stored inline and contain atomics, a FSM with a mailbox can not be copied or moved.
+     */
+    template<class T_FSM_Child, std::size_t N_Capacity = 256, std::size_t N_Slot_Size = 48>
+    class Mailbox {
+
+        static_assert(
+            N_Capacity > 0 && (N_Capacity & (N_Capacity - 1)) == 0,
+            "capacity has to be a power of two"
+        );
+
+      public:
+
+        /**
+         * @brief number of slots
+         */
+        static constexpr std::size_t capacity = N_Capacity;
+
+        /**
+         * @brief maximum size of a posted event in bytes
+         */
+        static constexpr std::size_t slot_size = N_Slot_Size;
+
+        /**
+         * @brief destroys all events that were not drained
+         */
+        ~Mailbox()
+        {
+            Slot* slot = nullptr;
+            while((slot = front()) != nullptr) {
+                slot->thunk(nullptr, slot->storage);
+                pop();
+            }
+        };
+
+        Mailbox(const Mailbox&) = delete;
+        Mailbox& operator=(const Mailbox&) = delete;
+
+        /**
+         * @brief posts an event to the FSM, can be called from any thread
+         * @param event event to copy or move into the mailbox
+         * @return false if the mailbox is full and the event was dropped
+         */
+        template<class T_Event>
+        bool post(T_Event&& event)
+        {
+            using event_type = std::decay_t<T_Event>;
+            static_assert(sizeof(event_type) <= N_Slot_Size, "event does not fit into a slot");
+            static_assert(
+                alignof(event_type) <= alignof(std::max_align_t), "event is over-aligned"
+            );
+
+            std::size_t position = tail_.load(std::memory_order_relaxed);
+            Slot* slot = nullptr;
+            while(true) {
+                slot = &slots_[position & (N_Capacity - 1)];
+                const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                const auto difference =
+                    static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+                if(difference == 0) {
+                    // slot is free, try to claim it
+                    if(tail_.compare_exchange_weak(
+                           position, position + 1, std::memory_order_relaxed
+                       )) {
+                        break;
+                    }
+                } else if(difference < 0) {
+                    // slot still holds an event from the previous round
+                    return false;
+                } else {
+                    position = tail_.load(std::memory_order_relaxed);
+                }
+            }
+
+            ::new(static_cast<void*>(slot->storage)) event_type(std::forward<T_Event>(event));
+            slot->thunk = &thunk<event_type>;
+            slot->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief lets the FSM react to the posted events, only called by the owner thread
+         * @param max maximum number of events to process
+         * @return number of processed events
+         *
+         * Events posted while draining, also from the reactions, are processed in the same call
+         * until the mailbox is empty or max events were processed.
+         */
+        std::size_t drain(std::size_t max = SIZE_MAX)
+        {
+            std::size_t count = 0;
+            Slot* slot = nullptr;
+            while(count < max && (slot = front()) != nullptr) {
+                slot->thunk(static_cast<T_FSM_Child*>(this), slot->storage);
+                pop();
+                ++count;
+            }
+            return count;
+        }
+
+        /**
+         * @brief checks if there are posted events, only called by the owner thread
+         */
+        inline bool empty() const
+        {
+            const Slot& slot = slots_[head_ & (N_Capacity - 1)];
+            return slot.sequence.load(std::memory_order_acquire) != head_ + 1;
+        }
+
+      protected:
+
+        /**
+         * @brief mailbox constructor
+         */
+        Mailbox()
+        {
+            for(std::size_t index = 0; index < N_Capacity; ++index) {
+                slots_[index].sequence.store(index, std::memory_order_relaxed);
+            }
+        };
+
+      private:
+
+        /**
+         * \internal
+         * @brief slot holding one event, on its own cache line
+         */
+        struct alignas(_cache_line) Slot {
+            /**
+             * \internal
+             * @brief position the slot is ready for, position + 1 once it holds an event
+             */
+            std::atomic<std::size_t> sequence;
+
+            /**
+             * \internal
+             * @brief reacts to and destroys the stored event, only destroys it if fsm is nullptr
+             */
+            void (*thunk)(T_FSM_Child* fsm, void* storage);
+
+            /**
+             * \internal
+             * @brief storage of the event
+             */
+            alignas(std::max_align_t) unsigned char storage[N_Slot_Size];
+        };
+
+        /**
+         * \internal
+         * @brief type-erased reaction for an event type
+         */
+        template<class T_Event>
+        static void thunk(T_FSM_Child* const fsm, void* const storage)
+        {
+            auto* const event = std::launder(static_cast<T_Event*>(storage));
+            if(fsm != nullptr) {
+                fsm->react(static_cast<const T_Event&>(*event));
+            }
+            event->~T_Event();
+        }
+
+        /**
+         * \internal
+         * @brief slot at the head of the ring if it holds an event
+         */
+        inline Slot* front()
+        {
+            Slot& slot = slots_[head_ & (N_Capacity - 1)];
+            return slot.sequence.load(std::memory_order_acquire) == head_ + 1 ? &slot : nullptr;
+        }
+
+        /**
+         * \internal
+         * @brief releases the slot at the head of the ring for the next round
+         */
+        inline void pop()
+        {
+            slots_[head_ & (N_Capacity - 1)].sequence.store(
+                head_ + N_Capacity, std::memory_order_release
+            );
+            ++head_;
+        }
+
+        /**
+         * \internal
+         * @brief ring of slots
+         */
+        Slot slots_[N_Capacity];
+
+        /**
+         * \internal
+         * @brief next position to post to, shared by all producers
+         */
+        alignas(_cache_line) std::atomic<std::size_t> tail_ {0};
+
+        /**
+         * \internal
+         * @brief next position to drain from, only used by the consumer
+         */
+        alignas(_cache_line) std::size_t head_ {0};
+    };
+
+}  // namespace scriptsizefsm
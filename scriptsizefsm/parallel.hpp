@@ -0,0 +1,538 @@
+/**
+ * @file
+ * @brief Parallel dispatch of events to many independent FSMs
+ *
+ * FSMs are independent of each other, so broadcasting an event to a large population can be done
+ * in parallel. The population is split into chunks whose boundaries lie on cache lines of the
+ * state column, the chunks are processed on a work-stealing `ThreadPool`, and the statistics of
+ * each chunk are merged after all chunks are done.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/fleet.hpp"
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * @brief thread pool with one task queue per worker and work stealing
+     *
+     * Workers take tasks from the back of their own queue and steal from the front of the other
+     * queues when their own queue is empty. Tasks submitted from a worker go into its own queue,
+     * tasks submitted from other threads are distributed round-robin. Tasks can be counted in a
+     * `Latch`, so that a batch of tasks can be waited for independently of other tasks.
+     */
+    class ThreadPool {
+
+      public:
+
+        /**
+         * @brief counter of the unfinished tasks of a batch, e.g. of one dispatch
+         *
+         * A latch has to outlive the tasks counted in it.
+         */
+        class Latch {
+
+            friend ThreadPool;
+
+          public:
+
+            Latch() = default;
+            Latch(const Latch&) = delete;
+            Latch& operator=(const Latch&) = delete;
+
+            /**
+             * @brief checks if all tasks counted in the latch are finished
+             */
+            inline bool done() const
+            {
+                return unfinished_.load(std::memory_order_acquire) == 0;
+            }
+
+          private:
+
+            std::atomic<std::size_t> unfinished_ {0};
+        };
+
+        /**
+         * @brief starts the worker threads
+         * @param threads number of worker threads, at least one
+         */
+        explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency())
+          : queues_(std::max<std::size_t>(threads, 1))
+        {
+            workers_.reserve(queues_.size());
+            for(std::size_t index = 0; index < queues_.size(); ++index) {
+                workers_.emplace_back([this, index]() { work(index); });
+            }
+        };
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief finishes all submitted tasks and joins the worker threads
+         */
+        ~ThreadPool()
+        {
+            wait();
+            {
+                const std::lock_guard<std::mutex> lock {wake_mutex_};
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for(auto& worker : workers_) {
+                worker.join();
+            }
+        };
+
+        /**
+         * @brief number of worker threads
+         */
+        inline std::size_t size() const
+        {
+            return workers_.size();
+        }
+
+        /**
+         * @brief submits a task
+         * @param task function object called without arguments
+         */
+        template<class T_Task>
+        inline void submit(T_Task&& task)
+        {
+            enqueue(std::forward<T_Task>(task), nullptr);
+        }
+
+        /**
+         * @brief submits a task counted in a latch
+         * @param task function object called without arguments
+         * @param latch latch counting the task until it is finished
+         */
+        template<class T_Task>
+        inline void submit(T_Task&& task, Latch& latch)
+        {
+            enqueue(std::forward<T_Task>(task), &latch);
+        }
+
+        /**
+         * @brief waits until all submitted tasks are finished
+         *
+         * The calling thread helps to process the queued tasks while waiting. Do not call this
+         * function from within a task, since the task itself is never finished while waiting.
+         */
+        inline void wait()
+        {
+            wait(all_);
+        }
+
+        /**
+         * @brief waits until all tasks counted in a latch are finished
+         *
+         * The calling thread helps to process the queued tasks, also of other batches, while
+         * waiting, but returns as soon as the batch is done. Do not call this function from
+         * within a task of the batch.
+         */
+        void wait(const Latch& latch)
+        {
+            while(!latch.done()) {
+                if(!run_one(current_worker().pool == this ? current_worker().index : 0)) {
+                    std::unique_lock<std::mutex> lock {wake_mutex_};
+                    done_.wait(lock, [this, &latch]() { return latch.done() || queued_ != 0; });
+                }
+            }
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief queued task with the latch counting it, if any
+         */
+        struct Task {
+            std::function<void()> func;
+            Latch* latch;
+        };
+
+        /**
+         * \internal
+         * @brief counts a task as finished when leaving its scope, also if the task throws
+         */
+        struct Finish {
+            ~Finish()
+            {
+                const bool batch_done =
+                    task.latch != nullptr &&
+                    task.latch->unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+                const bool all_done =
+                    pool.all_.unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+                if(batch_done || all_done) {
+                    const std::lock_guard<std::mutex> lock {pool.wake_mutex_};
+                    pool.done_.notify_all();
+                }
+            };
+            ThreadPool& pool;
+            const Task& task;
+        };
+
+        /**
+         * \internal
+         * @brief counts and queues a task
+         */
+        template<class T_Task>
+        void enqueue(T_Task&& task, Latch* const latch)
+        {
+            all_.unfinished_.fetch_add(1, std::memory_order_relaxed);
+            if(latch != nullptr) {
+                latch->unfinished_.fetch_add(1, std::memory_order_relaxed);
+            }
+            const auto& worker = current_worker();
+            const std::size_t index = worker.pool == this
+                                          ? worker.index
+                                          : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                                                queues_.size();
+            {
+                // counted before pushing, so a concurrent pop never sees a negative count
+                const std::lock_guard<std::mutex> lock {wake_mutex_};
+                ++queued_;
+            }
+            {
+                const std::lock_guard<std::mutex> lock {queues_[index].mutex};
+                queues_[index].tasks.push_back({std::forward<T_Task>(task), latch});
+            }
+            wake_.notify_one();
+        }
+
+        /**
+         * \internal
+         * @brief task queue of a worker, padded to avoid false sharing
+         */
+        struct alignas(_cache_line) Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        /**
+         * \internal
+         * @brief identifies the pool and queue of the calling worker thread
+         */
+        struct Worker {
+            ThreadPool* pool;
+            std::size_t index;
+        };
+
+        /**
+         * \internal
+         * @brief worker identity of the calling thread
+         */
+        static Worker& current_worker()
+        {
+            static thread_local Worker worker {nullptr, 0};
+            return worker;
+        }
+
+        /**
+         * \internal
+         * @brief takes a task from the own queue or steals one from another queue
+         */
+        bool pop(std::size_t index, Task& task)
+        {
+            {
+                auto& queue = queues_[index];
+                const std::lock_guard<std::mutex> lock {queue.mutex};
+                if(!queue.tasks.empty()) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                    return true;
+                }
+            }
+            for(std::size_t offset = 1; offset < queues_.size(); ++offset) {
+                auto& queue = queues_[(index + offset) % queues_.size()];
+                const std::lock_guard<std::mutex> lock {queue.mutex};
+                if(!queue.tasks.empty()) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * \internal
+         * @brief runs a single task if one is available
+         */
+        bool run_one(std::size_t index)
+        {
+            Task task {};
+            if(!pop(index, task)) {
+                return false;
+            }
+            {
+                const std::lock_guard<std::mutex> lock {wake_mutex_};
+                --queued_;
+            }
+            const Finish finish {*this, task};
+            task.func();
+            return true;
+        }
+
+        /**
+         * \internal
+         * @brief main loop of a worker thread
+         */
+        void work(std::size_t index)
+        {
+            current_worker() = {this, index};
+            while(true) {
+                if(run_one(index)) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock {wake_mutex_};
+                wake_.wait(lock, [this]() { return stop_ || queued_ != 0; });
+                if(stop_ && queued_ == 0) {
+                    return;
+                }
+            }
+        }
+
+        /**
+         * \internal
+         * @brief task queue per worker
+         */
+        std::vector<Queue> queues_;
+
+        /**
+         * \internal
+         * @brief worker threads
+         */
+        std::vector<std::thread> workers_;
+
+        /**
+         * \internal
+         * @brief latch counting all submitted tasks
+         */
+        Latch all_ {};
+
+        /**
+         * \internal
+         * @brief queue for the next task submitted from outside of the pool
+         */
+        std::atomic<std::size_t> next_queue_ {0};
+
+        /**
+         * \internal
+         * @brief protects queued_ and stop_, used for sleeping
+         */
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        std::size_t queued_ {0};
+        bool stop_ {false};
+    };
+
+    /**
+     * @brief statistics of a dispatch
+     * @tparam T_State_List `StateList` of the FSMs
+     */
+    template<class T_State_List>
+    struct alignas(_cache_line) DispatchStats {
+        /**
+         * @brief number of FSMs that changed their state
+         */
+        std::size_t transitions {0};
+
+        /**
+         * @brief number of FSMs in each state after the dispatch
+         */
+        std::array<std::size_t, T_State_List::size> states {};
+
+        /**
+         * @brief adds the statistics of another dispatch
+         */
+        DispatchStats& merge(const DispatchStats& other)
+        {
+            transitions += other.transitions;
+            for(std::size_t state = 0; state < T_State_List::size; ++state) {
+                states[state] += other.states[state];
+            }
+            return *this;
+        }
+
+        /**
+         * @brief number of FSMs in a given state after the dispatch
+         * @tparam T_State state to look up
+         */
+        template<class T_State>
+        inline std::size_t count() const
+        {
+            return states[index_of<T_State, T_State_List>];
+        }
+    };
+
+    /**
+     * \internal
+     * @brief splits a range into chunks starting on cache lines and processes them on a pool
+     * @param first address of the first element of the column the chunks should be aligned to
+     * @param element size of an element of that column in bytes
+     * @param func called as `func(begin, end, stats)` for each chunk
+     */
+    template<class T_State_List, class T_Func>
+    DispatchStats<T_State_List> _parallel_chunks(
+        ThreadPool& pool,
+        const void* const first,
+        std::size_t element,
+        std::size_t count,
+        std::size_t chunk_size,
+        T_Func&& func
+    )
+    {
+        // chunks span a multiple of the cache line size, so if the first one ends on a cache line
+        // boundary, all of them do
+        std::size_t line = 1;
+        while(line * element % _cache_line != 0) {
+            ++line;
+        }
+        chunk_size = std::max((chunk_size + line - 1) / line * line, line);
+        const auto address = reinterpret_cast<std::uintptr_t>(first);
+        std::size_t head = 0;
+        while(head < line && (address + head * element) % _cache_line != 0) {
+            ++head;
+        }
+        head = head == line ? 0 : head;
+
+        std::vector<std::size_t> bounds {0};
+        for(std::size_t end = head == 0 ? chunk_size : head; end < count; end += chunk_size) {
+            bounds.push_back(end);
+        }
+        bounds.push_back(count);
+
+        // only the chunks of this dispatch are waited for, not other tasks running on the pool
+        std::vector<DispatchStats<T_State_List>> stats(bounds.size() - 1);
+        ThreadPool::Latch chunks {};
+        for(std::size_t chunk = 0; chunk + 1 < bounds.size(); ++chunk) {
+            pool.submit(
+                [&func, &stats, &bounds, chunk]() {
+                    func(bounds[chunk], bounds[chunk + 1], stats[chunk]);
+                },
+                chunks
+            );
+        }
+        pool.wait(chunks);
+
+        DispatchStats<T_State_List> total {};
+        for(const auto& chunk_stats : stats) {
+            total.merge(chunk_stats);
+        }
+        return total;
+    }
+
+    /**
+     * @brief lets all FSMs of a fleet react to an event in parallel
+     * @param pool thread pool to run on
+     * @param fleet fleet of FSMs
+     * @param event event to react to
+     * @param chunk_size minimum number of FSMs per task, rounded up to whole cache lines
+     * @return merged statistics of all chunks
+     */
+    template<class T_FSM, class T_Event>
+    DispatchStats<typename T_FSM::state_list> parallel_broadcast(
+        ThreadPool& pool,
+        Fleet<T_FSM>& fleet,
+        const T_Event& event,
+        std::size_t chunk_size = 4096
+    )
+    {
+        using state_list = typename T_FSM::state_list;
+        auto* const states = fleet.states();
+        return _parallel_chunks<state_list>(
+            pool,
+            states,
+            sizeof(*states),
+            fleet.size(),
+            chunk_size,
+            [&fleet, &event, states](std::size_t begin, std::size_t end, auto& stats) {
+                _rtc_context batch {nullptr};
+                for(std::size_t id = begin; id < end; ++id) {
+                    const auto from = states[id];
+                    fleet[id]._react_batched(batch, event);
+                    stats.transitions += states[id] != from ? 1 : 0;
+                    ++stats.states[states[id]];
+                }
+            }
+        );
+    }
+
+    /**
+     * @brief lets independent FSMs with a state list react to an event in parallel
+     * @param pool thread pool to run on
+     * @param fsms pointer to the first FSM, e.g. of a `std::vector` of `CompactFSM`s
+     * @param count number of FSMs
+     * @param event event to react to
+     * @param chunk_size minimum number of FSMs per task, rounded up to whole cache lines
+     * @return merged statistics of all chunks
+     */
+    template<class T_FSM, class T_Event>
+    DispatchStats<typename T_FSM::state_list> parallel_broadcast(
+        ThreadPool& pool,
+        T_FSM* const fsms,
+        std::size_t count,
+        const T_Event& event,
+        std::size_t chunk_size = 4096
+    )
+    {
+        return _parallel_chunks<typename T_FSM::state_list>(
+            pool,
+            fsms,
+            sizeof(T_FSM),
+            count,
+            chunk_size,
+            [fsms, &event](std::size_t begin, std::size_t end, auto& stats) {
+                for(std::size_t index = begin; index < end; ++index) {
+                    const auto from = fsms[index].state_id();
+                    fsms[index].react(event);
+                    stats.transitions += fsms[index].state_id() != from ? 1 : 0;
+                    ++stats.states[fsms[index].state_id()];
+                }
+            }
+        );
+    }
+
+    /**
+     * @brief lets all FSMs in a container react to an event in parallel
+     * @param pool thread pool to run on
+     * @param fsms contiguous container of FSMs, e.g. a `std::vector`
+     * @param event event to react to
+     * @param chunk_size minimum number of FSMs per task, rounded up to whole cache lines
+     * @return merged statistics of all chunks
+     */
+    template<class T_Container, class T_Event>
+    inline auto parallel_broadcast(
+        ThreadPool& pool,
+        T_Container& fsms,
+        const T_Event& event,
+        std::size_t chunk_size = 4096
+    )
+    {
+        return parallel_broadcast(pool, std::data(fsms), std::size(fsms), event, chunk_size);
+    }
+
+}  // namespace scriptsizefsm
@@ -0,0 +1,501 @@
+/**
+ * @file
+ * @brief Flight recorder keeping the recent reactions and transitions of FSMs
+ *
+ * A `FlightRecorder` is a lock-free ring buffer of compact records, written by `FlightTracer`
+ * on every reaction, transition and reset. It can be shared by all FSMs of a thread or of a
+ * fleet, and is written to a binary file on demand or when the process receives a fatal signal.
+ * The file is decoded offline with the `trace_decode` tool, which prints the trace with the names
+ * of the states and events. Dumping uses POSIX file functions.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "scriptsizefsm/histogram.hpp"
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    class FlightRecorder;
+
+    /**
+     * \internal
+     * @brief recorder registered for dumping on a fatal signal
+     */
+    struct _crash_dump {
+        static constexpr std::size_t max_path = 256;
+        std::atomic<bool> claimed {false};
+        std::atomic<const FlightRecorder*> recorder {nullptr};
+        std::array<char, max_path> path {};
+    };
+
+    /**
+     * \internal
+     * @brief recorders registered for dumping on a fatal signal
+     */
+    inline std::array<_crash_dump, 16> _crash_dumps {};
+
+    /**
+     * @brief lock-free ring buffer of the recent reactions and transitions of FSMs
+     *
+     * Records are claimed with an atomic increment, so several threads can record into the same
+     * recorder. Once the buffer is full, the oldest records are overwritten. Every slot of the
+     * buffer is guarded by a sequence number, so a record that is overwritten while it is read,
+     * e.g. during a dump, is detected as torn instead of being returned with mixed fields. If a
+     * writer laps the whole buffer while another one is still writing a slot, the newer record is
+     * dropped.
+     */
+    class FlightRecorder {
+
+      public:
+
+        /**
+         * @brief what a record describes
+         */
+        enum class Kind : std::uint16_t
+        {
+            react,
+            transit,
+            reset,
+        };
+
+        /**
+         * @brief single entry of the ring buffer
+         */
+        struct Record {
+            /**
+             * @brief `timestamp` at which the record was written
+             */
+            std::uint64_t timestamp;
+
+            /**
+             * @brief id of the FSM instance, given when attaching the tracer
+             */
+            std::uint32_t instance;
+
+            /**
+             * @brief index of the state before, the current state for reactions and resets
+             */
+            std::uint16_t from;
+
+            /**
+             * @brief index of the state after, the current state for reactions and resets
+             */
+            std::uint16_t to;
+
+            /**
+             * @brief index of the event in the event list, `no_event` for resets
+             */
+            std::uint16_t event;
+
+            Kind kind;
+
+            /**
+             * @brief non-zero if the record was overwritten while it was read, e.g. during a dump
+             *
+             * All other fields of a torn record are zero.
+             */
+            std::uint32_t torn;
+        };
+
+        /**
+         * @brief beginning of a dump, followed by the names and then all records of the buffer
+         *
+         * The names are the null-terminated `typeid` names of all states and then all events.
+         * The records are stored as in the buffer, the oldest one is at index `written` modulo
+         * `capacity` if the buffer is full and at index zero otherwise. Records that were torn
+         * while dumping are marked with `torn`.
+         */
+        struct Header {
+            std::array<char, 8> magic;
+            std::uint32_t record_size;
+            std::uint32_t reserved;
+            std::uint64_t capacity;
+            std::uint64_t written;
+            std::uint32_t n_states;
+            std::uint32_t n_events;
+            std::uint64_t names_size;
+        };
+
+        /**
+         * @brief identifier at the beginning of a dump
+         */
+        static constexpr std::array<char, 8> magic {'S', 'S', 'F', 'S', 'M', 'F', 'R', '1'};
+
+        /**
+         * @brief event id of records not caused by an event in the event list
+         */
+        static constexpr std::uint16_t no_event = UINT16_MAX;
+
+        /**
+         * @brief recorder constructor
+         * @param capacity number of records kept, rounded up to a power of two
+         * @param states `StateList` of all states of the recorded FSMs
+         * @param events `EventList` of all events of the recorded FSMs
+         */
+        template<class... T_States, class... T_Events>
+        FlightRecorder(std::size_t capacity, StateList<T_States...>, EventList<T_Events...>)
+          : n_states_(sizeof...(T_States)),
+            n_events_(sizeof...(T_Events))
+        {
+            static_assert(sizeof...(T_States) < no_event, "too many states");
+            static_assert(sizeof...(T_Events) < no_event, "too many events");
+            std::size_t size = 1;
+            while(size < capacity) {
+                size <<= 1U;
+            }
+            slots_.reset(new Slot[size]());
+            mask_ = size - 1;
+            for(const char* name : {typeid(T_States).name()..., typeid(T_Events).name()...}) {
+                names_.append(name);
+                names_.push_back('\0');
+            }
+        }
+
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        /**
+         * @brief stops dumping on fatal signals
+         */
+        ~FlightRecorder()
+        {
+            for(auto& crash_dump : _crash_dumps) {
+                if(crash_dump.recorder.load(std::memory_order_acquire) == this) {
+                    crash_dump.recorder.store(nullptr, std::memory_order_release);
+                    crash_dump.claimed.store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        /**
+         * @brief appends a record, overwriting the oldest one if the buffer is full
+         */
+        inline void record(
+            Kind kind,
+            std::uint32_t instance,
+            std::uint16_t from,
+            std::uint16_t to,
+            std::uint16_t event
+        )
+        {
+            const std::uint64_t index = written_.fetch_add(1, std::memory_order_relaxed);
+            const Record record {timestamp(), instance, from, to, event, kind, 0};
+            std::array<std::uint64_t, Slot::n_words> words {};
+            std::memcpy(words.data(), &record, sizeof(Record));
+            // odd while the record is written, so readers can detect that they raced with it, and
+            // claimed exclusively, so a writer that lapped the buffer drops its record instead of
+            // mixing it into the one still being written
+            Slot& slot = slots_[index & mask_];
+            std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+            do {
+                if((sequence & 1U) != 0 || sequence > 2 * index) {
+                    return;
+                }
+            } while(!slot.sequence.compare_exchange_weak(
+                sequence, 2 * index + 1, std::memory_order_relaxed
+            ));
+            std::atomic_thread_fence(std::memory_order_release);
+            for(std::size_t word = 0; word < Slot::n_words; ++word) {
+                slot.words[word].store(words[word], std::memory_order_relaxed);
+            }
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief number of records kept
+         */
+        inline std::size_t capacity() const
+        {
+            return mask_ + 1;
+        }
+
+        /**
+         * @brief number of records written since construction, including overwritten ones
+         */
+        inline std::uint64_t written() const
+        {
+            return written_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief copies the records that are kept, oldest first, leaving out torn records
+         */
+        std::vector<Record> records() const
+        {
+            const std::uint64_t end = written();
+            const std::uint64_t begin = end > capacity() ? end - capacity() : 0;
+            std::vector<Record> records {};
+            records.reserve(static_cast<std::size_t>(end - begin));
+            for(std::uint64_t index = begin; index < end; ++index) {
+                const Record record = read(index);
+                if(record.torn == 0) {
+                    records.push_back(record);
+                }
+            }
+            return records;
+        }
+
+        /**
+         * @brief writes the header, the names and the records to a file
+         * @param path file to write, replaced if it exists
+         * @return bool that is true if the file was written completely
+         *
+         * Only uses async-signal-safe functions, so it can be called from a signal handler.
+         */
+        bool dump(const char* path) const
+        {
+            const int file = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(file < 0) {
+                return false;
+            }
+            const Header header {
+                magic,
+                sizeof(Record),
+                0,
+                capacity(),
+                written(),
+                n_states_,
+                n_events_,
+                names_.size()};
+            bool complete = write_all(file, &header, sizeof(header)) &&
+                            write_all(file, names_.data(), names_.size());
+            // copied in chunks on the stack, since the heap can not be used in a signal handler
+            std::array<Record, 64> chunk {};
+            for(std::size_t slot = 0; complete && slot < capacity(); slot += chunk.size()) {
+                const std::size_t count = std::min(chunk.size(), capacity() - slot);
+                for(std::size_t offset = 0; offset < count; ++offset) {
+                    chunk[offset] = read_slot(slot + offset, header.written);
+                }
+                complete = write_all(file, chunk.data(), count * sizeof(Record));
+            }
+            return ::close(file) == 0 && complete;
+        }
+
+        /**
+         * @brief dumps the recorder when the process receives a fatal signal
+         * @param path file to write, at most 255 characters
+         * @return bool that is false if the path is too long or too many recorders are registered
+         *
+         * Handles SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT. After dumping all registered
+         * recorders, the signal is raised again with the default action. Up to 16 recorders can be
+         * registered at the same time, they are unregistered on destruction.
+         */
+        bool dump_on_fatal_signal(const char* path)
+        {
+            if(std::strlen(path) >= _crash_dump::max_path) {
+                return false;
+            }
+            for(auto& crash_dump : _crash_dumps) {
+                if(!crash_dump.claimed.exchange(true, std::memory_order_acq_rel)) {
+                    std::strcpy(crash_dump.path.data(), path);
+                    crash_dump.recorder.store(this, std::memory_order_release);
+                    install_signal_handlers();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief slot of the ring buffer, holding a record as words guarded by a sequence number
+         *
+         * The sequence number is twice the index of the record plus one while it is written and
+         * plus two once it is complete.
+         */
+        struct Slot {
+            static constexpr std::size_t n_words = sizeof(Record) / sizeof(std::uint64_t);
+            static_assert(sizeof(Record) == n_words * sizeof(std::uint64_t));
+            std::atomic<std::uint64_t> sequence;
+            std::array<std::atomic<std::uint64_t>, n_words> words;
+        };
+
+        /**
+         * \internal
+         * @brief copies a record, which is torn if the slot does not hold it completely
+         */
+        Record read(std::uint64_t index) const
+        {
+            const Slot& slot = slots_[index & mask_];
+            const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::array<std::uint64_t, Slot::n_words> words {};
+            for(std::size_t word = 0; word < Slot::n_words; ++word) {
+                words[word] = slot.words[word].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            Record record {};
+            if(sequence != 2 * index + 2 ||
+               slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                record.torn = 1;
+                return record;
+            }
+            std::memcpy(&record, words.data(), sizeof(Record));
+            return record;
+        }
+
+        /**
+         * \internal
+         * @brief copies the record in a slot that is the latest one before `end`, if any
+         */
+        Record read_slot(std::size_t slot, std::uint64_t end) const
+        {
+            if(slot >= end) {
+                return Record {};
+            }
+            return read(slot + (end - 1 - slot) / capacity() * capacity());
+        }
+
+        /**
+         * \internal
+         * @brief writes a buffer completely, retrying partial writes
+         */
+        static bool write_all(int file, const void* data, std::size_t size)
+        {
+            const auto* bytes = static_cast<const char*>(data);
+            while(size > 0) {
+                const ::ssize_t count = ::write(file, bytes, size);
+                if(count < 0) {
+                    return false;
+                }
+                bytes += count;
+                size -= static_cast<std::size_t>(count);
+            }
+            return true;
+        }
+
+        /**
+         * \internal
+         * @brief dumps all registered recorders and raises the signal again
+         */
+        static void on_fatal_signal(int signal)
+        {
+            for(const auto& crash_dump : _crash_dumps) {
+                const FlightRecorder* const recorder =
+                    crash_dump.recorder.load(std::memory_order_acquire);
+                if(recorder != nullptr) {
+                    recorder->dump(crash_dump.path.data());
+                }
+            }
+            // the handler was reset to the default action, which takes over once this one returns
+            std::raise(signal);
+        }
+
+        static void install_signal_handlers()
+        {
+            static const bool installed = []() {
+                struct sigaction action {};
+                action.sa_handler = &on_fatal_signal;
+                action.sa_flags = SA_RESETHAND;
+                sigemptyset(&action.sa_mask);
+                for(const int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+                    sigaction(signal, &action, nullptr);
+                }
+                return true;
+            }();
+            static_cast<void>(installed);
+        }
+
+        std::unique_ptr<Slot[]> slots_ {};
+        std::uint64_t mask_ {0};
+        std::atomic<std::uint64_t> written_ {0};
+        std::uint32_t n_states_;
+        std::uint32_t n_events_;
+        std::string names_ {};
+    };
+
+    /**
+     * @brief tracing policy writing every reaction, transition and reset to a `FlightRecorder`
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_Event_List `EventList` of the events that are recorded by index
+     *
+     * Transitions are recorded with the event of the reaction they happen in. Only works with the
+     * FSMs that identify states by index, i.e. not with `FSM`.
+     */
+    template<class T_State_List, class T_Event_List>
+    class FlightTracer : public NoTracer {
+
+      public:
+
+        /**
+         * @brief starts recording
+         * @param recorder recorder to write to, created with the same state and event lists
+         * @param instance id of the FSM in the records
+         */
+        inline void attach(FlightRecorder& recorder, std::uint32_t instance)
+        {
+            recorder_ = &recorder;
+            instance_ = instance;
+        }
+
+        /**
+         * @brief stops recording
+         */
+        inline void detach()
+        {
+            recorder_ = nullptr;
+        }
+
+        template<class T_FSM, class T_State_Id, class T_Event>
+        inline void on_react(const T_FSM& fsm, T_State_Id state, const T_Event& event)
+        {
+            event_ = _index_of<T_Event, T_Event_List>::found
+                         ? static_cast<std::uint16_t>(_index_of<T_Event, T_Event_List>::value)
+                         : FlightRecorder::no_event;
+            record(FlightRecorder::Kind::react, state, state);
+        }
+
+        template<class T_FSM, class T_State_Id>
+        inline void on_transit(const T_FSM& fsm, T_State_Id from, T_State_Id to)
+        {
+            record(FlightRecorder::Kind::transit, from, to);
+        }
+
+        template<class T_FSM>
+        inline void on_reset(const T_FSM& fsm)
+        {
+            event_ = FlightRecorder::no_event;
+            record(FlightRecorder::Kind::reset, fsm.state_id(), fsm.state_id());
+        }
+
+      private:
+
+        inline void record(FlightRecorder::Kind kind, std::size_t from, std::size_t to)
+        {
+            if(recorder_ != nullptr) {
+                recorder_->record(
+                    kind,
+                    instance_,
+                    static_cast<std::uint16_t>(from),
+                    static_cast<std::uint16_t>(to),
+                    event_
+                );
+            }
+        }
+
+        FlightRecorder* recorder_ {nullptr};
+        std::uint32_t instance_ {0};
+        std::uint16_t event_ {FlightRecorder::no_event};
+    };
+
+}  // namespace scriptsizefsm
@@ -0,0 +1,325 @@
+/**
+ * @file
+ * @brief Finite state machine with orthogonal regions
+ *
+ * A `RegionFSM` consists of several independent regions, each with its own generic state, states
+ * and initial state, which are all active at the same time. The current states of all regions
+ * are packed into the bits of a single word, so an entity with several concerns needs one small
+ * FSM instead of one FSM per concern. An event is dispatched in a single pass into every region
+ * whose generic state has a reaction to it, the other regions are skipped at compile time.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * \internal
+     * @brief number of bits needed to store the values up to a given value
+     */
+    constexpr std::size_t _bit_width(std::size_t value)
+    {
+        std::size_t bits = 0;
+        for(; value != 0; value >>= 1U) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    /**
+     * @brief region of a `RegionFSM`
+     * @tparam T_State_Generic class of the generic state containing all reactions of the region
+     * @tparam T_State_List `StateList` of all states of the region
+     * @tparam T_State_Init initial state of the region
+     */
+    template<class T_State_Generic, class T_State_List, class T_State_Init>
+    struct Region {
+        static_assert(_index_of<T_State_Init, T_State_List>::found, "state not in state list");
+
+        using generic_state = T_State_Generic;
+        using state_list = T_State_List;
+        using init_state = T_State_Init;
+
+        /**
+         * @brief number of bits of the index of the current state
+         */
+        static constexpr std::size_t bits =
+            T_State_List::size > 1 ? _bit_width(T_State_List::size - 1) : 1;
+    };
+
+    /**
+     * @brief Finite State Machine class with orthogonal regions
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_Regions `Region` of each concern of the FSM
+     *
+     * The states of all regions derive from `State<T_FSM_Child>` and use `transit` as usual, which
+     * changes the state of the region the target state belongs to. A state must only be in one
+     * region. On an event, the regions react in the order in which they are given. Like
+     * `CompactFSM`, there are no virtual functions and the FSM implementation can hide
+     * `resetter()` to run code on reset.
+     */
+    template<class T_FSM_Child, class... T_Regions>
+    class RegionFSM {
+
+        friend State<T_FSM_Child>;
+
+      public:
+
+        /**
+         * @brief list of all regions of the FSM
+         */
+        using region_list = TypeList<T_Regions...>;
+
+        /**
+         * @brief number of bits of the packed current states
+         */
+        static constexpr std::size_t n_bits = (T_Regions::bits + ...);
+
+        static_assert(n_bits <= 64, "the current states of all regions need more than 64 bits");
+
+        /**
+         * @brief smallest unsigned type that can hold the current states of all regions
+         */
+        using word_type = std::conditional_t<
+            n_bits <= 8,
+            std::uint8_t,
+            std::conditional_t<
+                n_bits <= 16,
+                std::uint16_t,
+                std::conditional_t<n_bits <= 32, std::uint32_t, std::uint64_t>>>;
+
+        /**
+         * @brief starts the FSM in the initial states of all regions
+         * @tparam T_Arg argument types for the FSM constructor
+         * @param args arguments for the FSM constructor
+         */
+        template<typename... T_Arg>
+        static T_FSM_Child start(T_Arg... args)
+        {
+            return T_FSM_Child {args...};
+        }
+
+        /**
+         * @brief reacts to a given event in every region that has a reaction to it
+         * @tparam T_Event event class to react to
+         * @param event event to react to
+         * @note at least one generic state needs to have a react function for the event
+         */
+        template<class T_Event>
+        inline void react(const T_Event& event)
+        {
+            static_assert(
+                (_declares_react<typename T_Regions::generic_state, T_FSM_Child, T_Event>::value ||
+                 ...),
+                "no region reacts to the event"
+            );
+            _rtc_react(&state_, static_cast<T_FSM_Child*>(this), &dispatch<T_Event>, event);
+        }
+
+        /**
+         * @brief resets the FSM
+         *
+         * This function exits the current states of all regions and enters their initial states.
+         */
+        void reset()
+        {
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            _rtc_run(&state_, fsm, [this, fsm]() {
+                _for_each_index<region_list>([this, fsm](auto tag, std::size_t region) {
+                    using T_Region = typename decltype(tag)::type;
+                    if constexpr(_any_overrides_exit<T_FSM_Child>(typename T_Region::state_list {})
+                    ) {
+                        _visit<typename T_Region::state_list>(get(region), [fsm](auto state) {
+                            _state_exit<typename decltype(state)::type>(fsm);
+                        });
+                    }
+                });
+                state_ = init_word();
+                fsm->resetter();
+                _for_each_index<region_list>([this, fsm](auto tag, std::size_t region) {
+                    using T_Region = typename decltype(tag)::type;
+                    if constexpr(_any_overrides_entry<T_FSM_Child>(typename T_Region::state_list {}
+                                 )) {
+                        _visit<typename T_Region::state_list>(get(region), [fsm](auto state) {
+                            _state_entry<typename decltype(state)::type>(fsm);
+                        });
+                    }
+                });
+            });
+        };
+
+        /**
+         * @brief checks if the region of a given state is in that state
+         * @tparam state to check for
+         * @return bool that is true if the region of the state is in the state
+         */
+        template<class T_State>
+        inline bool is_in_state() const
+        {
+            constexpr std::size_t region = region_of<T_State>();
+            using T_State_List = typename region_type<region>::state_list;
+            return get(region) == index_of<T_State, T_State_List>;
+        }
+
+        /**
+         * @brief index of the current state of a region in the state list of the region
+         * @tparam N_Region index of the region
+         */
+        template<std::size_t N_Region>
+        inline std::size_t state_id() const
+        {
+            static_assert(N_Region < sizeof...(T_Regions), "region out of range");
+            return get(N_Region);
+        }
+
+      protected:
+
+        /**
+         * @brief FSM state transition function
+         * @tparam state to transition to, changes the state of its region
+         */
+        template<class T_State>
+        void transit()
+        {
+            constexpr std::size_t region = region_of<T_State>();
+            using T_State_List = typename region_type<region>::state_list;
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            if constexpr(_any_overrides_exit<T_FSM_Child>(T_State_List {})) {
+                _visit<T_State_List>(get(region), [fsm](auto tag) {
+                    _state_exit<typename decltype(tag)::type>(fsm);
+                });
+            }
+            set(region, index_of<T_State, T_State_List>);
+            _state_entry<T_State>(fsm);
+        }
+
+        /**
+         * @brief FSM constructor
+         */
+        RegionFSM()
+          : state_(init_word()) {};
+
+        /**
+         * @brief additional function called on reset
+         *
+         * Hide this function in the FSM implementation to run code on reset.
+         */
+        void resetter() {};
+
+      private:
+
+        template<std::size_t N_Region>
+        using region_type = std::tuple_element_t<N_Region, std::tuple<T_Regions...>>;
+
+        /**
+         * \internal
+         * @brief bit offset of the current state of each region
+         */
+        static constexpr std::array<std::size_t, sizeof...(T_Regions)> offsets()
+        {
+            constexpr std::array<std::size_t, sizeof...(T_Regions)> bits {T_Regions::bits...};
+            std::array<std::size_t, sizeof...(T_Regions)> offsets {};
+            for(std::size_t region = 1; region < bits.size(); ++region) {
+                offsets[region] = offsets[region - 1] + bits[region - 1];
+            }
+            return offsets;
+        }
+
+        static constexpr std::array<std::size_t, sizeof...(T_Regions)> offsets_ = offsets();
+
+        static constexpr std::array<word_type, sizeof...(T_Regions)> masks_ {
+            static_cast<word_type>((std::uint64_t {1} << T_Regions::bits) - 1)...};
+
+        /**
+         * \internal
+         * @brief index of the region a state belongs to
+         */
+        template<class T_State>
+        static constexpr std::size_t region_of()
+        {
+            constexpr bool found[] = {_index_of<T_State, typename T_Regions::state_list>::found...};
+            std::size_t region = 0;
+            while(region < sizeof...(T_Regions) && !found[region]) {
+                ++region;
+            }
+            static_assert(
+                ((_index_of<T_State, typename T_Regions::state_list>::found ? 1 : 0) + ...) == 1,
+                "state not in exactly one region"
+            );
+            return region;
+        }
+
+        /**
+         * \internal
+         * @brief packed initial states of all regions
+         */
+        static constexpr word_type init_word()
+        {
+            word_type word = 0;
+            std::size_t region = 0;
+            static_cast<void>(
+                ((word |= static_cast<word_type>(
+                      index_of<typename T_Regions::init_state, typename T_Regions::state_list>
+                      << offsets_[region++]
+                  )),
+                 ...)
+            );
+            return word;
+        }
+
+        inline std::size_t get(std::size_t region) const
+        {
+            return (state_ >> offsets_[region]) & masks_[region];
+        }
+
+        inline void set(std::size_t region, std::size_t index)
+        {
+            state_ = static_cast<word_type>(
+                (state_ & ~(masks_[region] << offsets_[region])) | (index << offsets_[region])
+            );
+        }
+
+        /**
+         * \internal
+         * @brief dispatches an event to the current state of every region that reacts to it
+         */
+        template<class T_Event>
+        static void dispatch(void* const fsm, const void* const event)
+        {
+            auto* const child = static_cast<T_FSM_Child*>(fsm);
+            RegionFSM* const base = child;
+            const auto& typed_event = *static_cast<const T_Event*>(event);
+            _for_each_index<region_list>([base, child, &typed_event](auto tag, std::size_t region) {
+                using T_Region = typename decltype(tag)::type;
+                using T_Generic = typename T_Region::generic_state;
+                if constexpr(_declares_react<T_Generic, T_FSM_Child, T_Event>::value) {
+                    _visit<typename T_Region::state_list>(
+                        base->get(region), [child, &typed_event](auto state) {
+                            _state_react<T_Generic, typename decltype(state)::type>(
+                                child, typed_event
+                            );
+                        }
+                    );
+                }
+            });
+        }
+
+        /**
+         * \internal
+         * @brief indices of the current states of all regions, packed into bit fields
+         */
+        word_type state_;
+    };
+
+}  // namespace scriptsizefsm
@@ -14,6 +14,31 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief requires a variable with static storage to be constant initialized
+ *
+ * Expands to `constinit` in C++20 and to the equivalent extension of the compiler otherwise, so
+ * that e.g. a `ConstexprFSM` or a table computed from it needs no initialization at startup.
+ * Expands to nothing if the compiler has no such extension.
+ */
+#if defined(__cpp_constinit)
+#define SCRIPTSIZEFSM_CONSTINIT constinit
+#elif defined(__clang__)
+#define SCRIPTSIZEFSM_CONSTINIT [[clang::require_constant_initialization]]
+#elif defined(__GNUC__) && __GNUC__ >= 10
+#define SCRIPTSIZEFSM_CONSTINIT __constinit
+#else
+#define SCRIPTSIZEFSM_CONSTINIT
+#endif
+
 namespace scriptsizefsm {
 
     /// @{
@@ -33,6 +58,491 @@ namespace scriptsizefsm {
     typename _state_instance<S>::value_type _state_instance<S>::value;
     /// @}
 
+    /**
+     * @brief compile-time list of types
+     * @tparam T_Types types in the list
+     *
+     * Used to pass the complete set of states (or events) of a FSM to the dispatch modes that
+     * need to know all of them at compile time.
+     */
+    template<class... T_Types>
+    struct TypeList {
+        static constexpr std::size_t size = sizeof...(T_Types);
+    };
+
+    /**
+     * @brief list of all states of a FSM
+     */
+    template<class... T_States>
+    using StateList = TypeList<T_States...>;
+
+    /**
+     * @brief list of all events of a FSM
+     */
+    template<class... T_Events>
+    using EventList = TypeList<T_Events...>;
+
+    /// @{
+    /**
+     * \internal
+     * @brief internal type list helper definitions
+     */
+    template<class T_Type, class T_List>
+    struct _index_of;
+
+    template<class T_Type, class... T_Types>
+    struct _index_of<T_Type, TypeList<T_Types...>> {
+        static constexpr std::size_t find()
+        {
+            constexpr bool matches[] = {std::is_same_v<T_Type, T_Types>..., false};
+            std::size_t index = 0;
+            while(index < sizeof...(T_Types) && !matches[index]) {
+                ++index;
+            }
+            return index;
+        }
+
+        static constexpr std::size_t value = find();
+        static constexpr bool found = value < sizeof...(T_Types);
+    };
+
+    template<std::size_t N>
+    using _index_type = std::conditional_t<
+        (N <= UINT8_MAX + 1U),
+        std::uint8_t,
+        std::conditional_t<(N <= UINT16_MAX + 1U), std::uint16_t, std::uint32_t>>;
+
+    /**
+     * \internal
+     * @brief index of the highest set bit of a non-zero mask
+     */
+    inline unsigned int _highest_bit(std::uint64_t mask)
+    {
+#if defined(__GNUC__)
+        return 63U - static_cast<unsigned int>(__builtin_clzll(mask));
+#else
+        unsigned int bit = 0;
+        while((mask >>= 1U) != 0) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    /**
+     * \internal
+     * @brief index of the lowest set bit of a non-zero mask
+     * @tparam T_Mask unsigned integer type of the mask, at most 64 bits
+     */
+    template<class T_Mask>
+    inline unsigned int _lowest_bit(T_Mask mask)
+    {
+        static_assert(std::is_unsigned_v<T_Mask> && sizeof(T_Mask) <= sizeof(std::uint64_t));
+#if defined(__GNUC__)
+        if constexpr(sizeof(T_Mask) <= sizeof(unsigned int)) {
+            return static_cast<unsigned int>(__builtin_ctz(mask));
+        } else {
+            return static_cast<unsigned int>(__builtin_ctzll(mask));
+        }
+#else
+        unsigned int bit = 0;
+        while((mask & 1U) == 0) {
+            mask >>= 1U;
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    /**
+     * \internal
+     * @brief assumed size of a cache line in bytes
+     */
+    inline constexpr std::size_t _cache_line = 64;
+
+    template<class T_Type>
+    struct _type_tag {
+        using type = T_Type;
+    };
+
+    template<class... T_Types, std::size_t... I, class T_Func>
+    constexpr void _visit_impl(
+        TypeList<T_Types...>,
+        std::index_sequence<I...>,
+        std::size_t index,
+        T_Func&& func
+    )
+    {
+        // expands into a chain of compares the compiler turns into a jump table
+        static_cast<void>(((index == I ? (func(_type_tag<T_Types> {}), true) : false) || ...));
+    }
+
+    template<class... T_Types, std::size_t... I, class T_Func>
+    constexpr void _for_each_index_impl(
+        TypeList<T_Types...>,
+        std::index_sequence<I...>,
+        T_Func&& func
+    )
+    {
+        (func(_type_tag<T_Types> {}, I), ...);
+    }
+    /// @}
+
+    /**
+     * @brief index of a type in a type list
+     * @tparam T_Type type to look up
+     * @tparam T_List type list to search in
+     */
+    template<class T_Type, class T_List>
+    inline constexpr std::size_t index_of = _index_of<T_Type, T_List>::value;
+
+    /**
+     * \internal
+     * @brief calls a function object with the type tag of the type at a runtime index of a list
+     */
+    template<class T_List, class T_Func>
+    constexpr void _visit(std::size_t index, T_Func&& func)
+    {
+        _visit_impl(
+            T_List {}, std::make_index_sequence<T_List::size> {}, index, std::forward<T_Func>(func)
+        );
+    }
+
+    /**
+     * \internal
+     * @brief type-erased dispatch of an event to a FSM
+     */
+    using _rtc_dispatch = void (*)(void* fsm, const void* event);
+
+    /**
+     * \internal
+     * @brief queue of events raised while a FSM is reacting
+     *
+     * Small trivially copyable events are stored inline, all other events are copied to the heap.
+     */
+    class _rtc_queue {
+
+      public:
+
+        _rtc_queue() = default;
+        _rtc_queue(const _rtc_queue&) = delete;
+        _rtc_queue& operator=(const _rtc_queue&) = delete;
+
+        ~_rtc_queue()
+        {
+            clear();
+        };
+
+        /**
+         * \internal
+         * @brief appends a copy of an event
+         */
+        template<class T_Event>
+        void push(_rtc_dispatch dispatch, const T_Event& event)
+        {
+            Entry entry {dispatch, nullptr, nullptr, {}};
+            if constexpr(
+                std::is_trivially_copyable_v<T_Event> && sizeof(T_Event) <= sizeof(entry.buffer) &&
+                alignof(T_Event) <= alignof(std::max_align_t)
+            ) {
+                ::new(static_cast<void*>(entry.buffer)) T_Event(event);
+            } else {
+                entry.heap = new T_Event(event);
+                entry.destroy = [](void* const heap) { delete static_cast<T_Event*>(heap); };
+            }
+            entries_.push_back(entry);
+        }
+
+        /**
+         * \internal
+         * @brief dispatches all queued events in order, including events queued meanwhile
+         */
+        void run(void* const fsm)
+        {
+            for(; head_ < entries_.size(); ++head_) {
+                // copied, since dispatching can append to the queue
+                Entry entry = entries_[head_];
+                entry.dispatch(fsm, entry.heap != nullptr ? entry.heap : entry.buffer);
+                destroy(entry);
+            }
+            clear();
+        }
+
+        /**
+         * \internal
+         * @brief destroys all remaining events, keeping the allocated memory
+         */
+        void clear()
+        {
+            for(; head_ < entries_.size(); ++head_) {
+                destroy(entries_[head_]);
+            }
+            entries_.clear();
+            head_ = 0;
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief queued event
+         */
+        struct Entry {
+            _rtc_dispatch dispatch;
+            void* heap;
+            void (*destroy)(void* heap);
+            alignas(std::max_align_t) unsigned char buffer[32];
+        };
+
+        static inline void destroy(const Entry& entry)
+        {
+            if(entry.destroy != nullptr) {
+                entry.destroy(entry.heap);
+            }
+        }
+
+        std::vector<Entry> entries_;
+        std::size_t head_ {0};
+    };
+
+    /**
+     * \internal
+     * @brief run-to-completion context of a FSM that is reacting on the current thread
+     *
+     * Contexts of nested reactions of different FSMs form a stack per thread. The queue is only
+     * acquired once an event is raised, so a reaction without raised events only touches the
+     * thread-local stack pointer.
+     */
+    class _rtc_context {
+
+      public:
+
+        _rtc_context(const void* const key)
+          : key_(key),
+            outer_(current())
+        {
+            current() = this;
+        };
+
+        _rtc_context(const _rtc_context&) = delete;
+        _rtc_context& operator=(const _rtc_context&) = delete;
+
+        [[gnu::always_inline]] ~_rtc_context()
+        {
+            current() = outer_;
+            if(queue_ != nullptr) {
+                release(queue_);
+            }
+        };
+
+        /**
+         * \internal
+         * @brief context of the FSM with the given key if it is reacting on the current thread
+         */
+        static inline _rtc_context* find(const void* const key)
+        {
+            for(auto* context = current(); context != nullptr; context = context->outer_) {
+                if(context->key_ == key) {
+                    return context;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * \internal
+         * @brief queues an event raised during the reaction
+         *
+         * Kept out of line, so that the fast path of a reaction stays small.
+         */
+        template<class T_Event>
+        [[gnu::noinline]] void push(_rtc_dispatch dispatch, const T_Event& event)
+        {
+            if(queue_ == nullptr) {
+                queue_ = acquire();
+            }
+            queue_->push(dispatch, event);
+        }
+
+        /**
+         * \internal
+         * @brief checks if the context was opened during the reaction of a FSM
+         */
+        inline bool nested() const
+        {
+            return outer_ != nullptr;
+        }
+
+        /**
+         * \internal
+         * @brief lets the context stand for another FSM, used for the FSMs of a batch
+         */
+        inline void rekey(const void* const key)
+        {
+            key_ = key;
+        }
+
+        /**
+         * \internal
+         * @brief dispatches the queued events, if any
+         */
+        inline void complete(void* const fsm)
+        {
+            if(queue_ != nullptr) {
+                run(fsm);
+            }
+        }
+
+      private:
+
+        static inline _rtc_context*& current()
+        {
+            static thread_local _rtc_context* context {nullptr};
+            return context;
+        }
+
+        [[gnu::noinline]] void run(void* const fsm)
+        {
+            queue_->run(fsm);
+        }
+
+        /**
+         * \internal
+         * @brief spare queue of the current thread, so that chatty FSMs do not allocate every time
+         */
+        struct Spare {
+            ~Spare()
+            {
+                delete queue;
+            };
+            _rtc_queue* queue {nullptr};
+        };
+
+        static inline Spare& spare()
+        {
+            static thread_local Spare spare {};
+            return spare;
+        }
+
+        static _rtc_queue* acquire()
+        {
+            auto* const queue = spare().queue;
+            spare().queue = nullptr;
+            return queue != nullptr ? queue : new _rtc_queue();
+        }
+
+        [[gnu::noinline]] static void release(_rtc_queue* const queue)
+        {
+            queue->clear();
+            if(spare().queue == nullptr) {
+                spare().queue = queue;
+            } else {
+                delete queue;
+            }
+        }
+
+        const void* key_;
+        _rtc_context* outer_;
+        _rtc_queue* queue_ {nullptr};
+    };
+
+    /// @{
+    /**
+     * \internal
+     * @brief runs a function with run-to-completion semantics
+     * @param key identity of the FSM, e.g. the address of its state storage
+     * @param fsm FSM to dispatch queued events to
+     * @param func function to run, e.g. a reaction or a reset
+     *
+     * Events raised by `func` for the same FSM are queued and dispatched in order after `func`
+     * returned. If the FSM is already reacting on this thread, `func` is simply called.
+     */
+    template<class T_Func>
+    inline void _rtc_run(const void* const key, void* const fsm, T_Func&& func)
+    {
+        if(_rtc_context::find(key) != nullptr) {
+            func();
+            return;
+        }
+        _rtc_context context {key};
+        func();
+        context.complete(fsm);
+    }
+
+    /**
+     * \internal
+     * @brief reacts to an event with run-to-completion semantics
+     * @param key identity of the FSM, e.g. the address of its state storage
+     * @param fsm FSM to dispatch to
+     * @param dispatch function dispatching the event to the FSM
+     * @param event event to react to
+     * @param direct optional function reacting to the event if it is not queued
+     *
+     * If the FSM is already reacting on this thread, the event is queued and dispatched after the
+     * current reaction, including its transition, completed. Otherwise the event is dispatched
+     * immediately.
+     */
+    template<class T_Event, class T_Func>
+    inline void _rtc_react(
+        const void* const key,
+        void* const fsm,
+        _rtc_dispatch dispatch,
+        const T_Event& event,
+        T_Func&& direct
+    )
+    {
+        auto* const running = _rtc_context::find(key);
+        if(running != nullptr) {
+            running->push(dispatch, event);
+            return;
+        }
+        _rtc_context context {key};
+        direct();
+        context.complete(fsm);
+    }
+
+    template<class T_Event>
+    inline void _rtc_react(
+        const void* const key,
+        void* const fsm,
+        _rtc_dispatch dispatch,
+        const T_Event& event
+    )
+    {
+        _rtc_react(key, fsm, dispatch, event, [fsm, dispatch, &event]() {
+            dispatch(fsm, &event);
+        });
+    }
+
+    /**
+     * \internal
+     * @brief reacts to an event with run-to-completion semantics, as one FSM of a batch
+     * @param batch context opened once for the whole batch, with a null key
+     *
+     * Outside of any reaction, no FSM of the batch can be reacting already, so the context of the
+     * batch is re-keyed for each FSM instead of searching the stack and opening a context per
+     * FSM. Batches started during a reaction take the path of single reactions.
+     */
+    template<class T_Event, class T_Func>
+    inline void _rtc_react(
+        _rtc_context& batch,
+        const void* const key,
+        void* const fsm,
+        _rtc_dispatch dispatch,
+        const T_Event& event,
+        T_Func&& direct
+    )
+    {
+        if(batch.nested()) {
+            _rtc_react(key, fsm, dispatch, event, std::forward<T_Func>(direct));
+            return;
+        }
+        batch.rekey(key);
+        direct();
+        batch.complete(fsm);
+    }
+    /// @}
+
     /**
      * @brief Event class
      *
@@ -104,15 +614,116 @@ namespace scriptsizefsm {
         }
     };
 
+    template<class T_FSM>
+    class ConstexprState;
+
+    /// @{
+    /**
+     * \internal
+     * @brief entry and exit call helpers that skip the functions states do not override
+     *
+     * The class declaring the function found in a state is detected at compile time. If it is
+     * the state base class, the function is empty and the call is left out. Otherwise the call is
+     * qualified and thus non-virtual, so that it can be inlined.
+     */
+    template<class T_FSM, class T_Class>
+    T_Class* _hook_class(void (T_Class::*)(T_FSM* const) const);
+
+    template<class T_Class, class T_FSM>
+    inline constexpr bool _is_overridden_hook =
+        !std::is_same_v<T_Class, State<T_FSM>> && !std::is_same_v<T_Class, ConstexprState<T_FSM>>;
+
+    template<class T_State, class T_FSM>
+    constexpr bool _overrides_entry()
+    {
+        using T_Class = std::remove_pointer_t<decltype(_hook_class<T_FSM>(&T_State::entry))>;
+        return _is_overridden_hook<T_Class, T_FSM>;
+    }
+
+    template<class T_State, class T_FSM>
+    constexpr bool _overrides_exit()
+    {
+        using T_Class = std::remove_pointer_t<decltype(_hook_class<T_FSM>(&T_State::exit))>;
+        return _is_overridden_hook<T_Class, T_FSM>;
+    }
+
+    template<class T_FSM, class... T_States>
+    constexpr bool _any_overrides_entry(TypeList<T_States...>)
+    {
+        return (_overrides_entry<T_States, T_FSM>() || ...);
+    }
+
+    template<class T_FSM, class... T_States>
+    constexpr bool _any_overrides_exit(TypeList<T_States...>)
+    {
+        return (_overrides_exit<T_States, T_FSM>() || ...);
+    }
+
+    template<class T_State, class T_FSM>
+    constexpr void _state_entry(T_FSM* const fsm)
+    {
+        if constexpr(_overrides_entry<T_State, T_FSM>()) {
+            _state_instance<T_State>::value.T_State::entry(fsm);
+        }
+    }
+
+    template<class T_State, class T_FSM>
+    constexpr void _state_exit(T_FSM* const fsm)
+    {
+        if constexpr(_overrides_exit<T_State, T_FSM>()) {
+            _state_instance<T_State>::value.T_State::exit(fsm);
+        }
+    }
+    /// @}
+
+    /**
+     * @brief tracing policy that does nothing, the default of the FSMs
+     *
+     * A tracer is a class with the functions below, which the FSM calls at the respective points.
+     * States are identified by a pointer to the state instance for `FSM` and by the index in the
+     * state list for the other FSMs. The FSM derives from its tracer, so this empty policy adds
+     * neither storage nor code.
+     */
+    struct NoTracer {
+        /**
+         * @brief called before a state reacts to an event
+         */
+        template<class T_FSM, class T_State_Id, class T_Event>
+        constexpr void on_react(const T_FSM& fsm, T_State_Id state, const T_Event& event) {}
+
+        /**
+         * @brief called after `on_react` if neither the state nor its ancestors have a reaction
+         * of their own to the event
+         *
+         * The event is then handled by the generic state. Not called by `FSM`, since its
+         * reactions are only known at run time.
+         */
+        template<class T_FSM, class T_State_Id, class T_Event>
+        constexpr void on_unhandled(const T_FSM& fsm, T_State_Id state, const T_Event& event) {}
+
+        /**
+         * @brief called on a transition, after the exit and before the entry function
+         */
+        template<class T_FSM, class T_State_Id>
+        constexpr void on_transit(const T_FSM& fsm, T_State_Id from, T_State_Id to) {}
+
+        /**
+         * @brief called on a reset, before the FSM returns to its initial state
+         */
+        template<class T_FSM>
+        constexpr void on_reset(const T_FSM& fsm) {}
+    };
+
     /**
      * @brief Finite State Machine class
      * @tparam T_FSM_Child class of the actual FSM implementation
      * @tparam T_State_Generic class of the generic state containing all reactions
+     * @tparam T_Tracer tracing policy, see `NoTracer`
      *
      * A FSM may
      */
-    template<class T_FSM_Child, class T_State_Generic>
-    class FSM {
+    template<class T_FSM_Child, class T_State_Generic, class T_Tracer = NoTracer>
+    class FSM : protected T_Tracer {
 
         friend State<T_FSM_Child>;
 
@@ -144,7 +755,7 @@ namespace scriptsizefsm {
         template<class T_Event>
         inline void react(const T_Event& event)
         {
-            current_state_->react(this_, event);
+            _rtc_react(this, self(), &dispatch<T_Event>, event);
         }
 
         /**
@@ -154,10 +765,13 @@ namespace scriptsizefsm {
          */
         void reset()
         {
-            current_state_->exit(this_);
-            current_state_ = init_state_;
-            resetter();
-            current_state_->entry(this_);
+            _rtc_run(this, self(), [this]() {
+                tracer().on_reset(*self());
+                current_state_->exit(self());
+                current_state_ = init_state_;
+                resetter();
+                current_state_->entry(self());
+            });
         };
 
         /**
@@ -171,18 +785,38 @@ namespace scriptsizefsm {
             return current_state_ == &_state_instance<T_State>::value;
         }
 
+        /// @{
+        /**
+         * @brief tracer of the FSM
+         */
+        inline T_Tracer& tracer()
+        {
+            return *this;
+        }
+
+        inline const T_Tracer& tracer() const
+        {
+            return *this;
+        }
+        /// @}
+
       protected:
 
         /**
          * @brief FSM state transition function
          * @tparam state to transition to
+         *
+         * Since the state to transition to is known, its entry function is called non-virtually,
+         * or not at all if the state does not override it.
          */
         template<class T_State>
         void transit()
         {
-            current_state_->exit(this_);
+            const T_State_Generic* const from = current_state_;
+            current_state_->exit(self());
             current_state_ = &_state_instance<T_State>::value;
-            current_state_->entry(this_);
+            tracer().on_transit(*self(), from, current_state_);
+            _state_entry<T_State>(self());
         }
 
         /**
@@ -190,10 +824,22 @@ namespace scriptsizefsm {
          * @param init_state initial state of the FSM
          */
         FSM(const T_State_Generic* const init_state)
-          : this_(static_cast<T_FSM_Child*>(this)),
-            init_state_(init_state),
+          : init_state_(init_state),
             current_state_(init_state) {};
 
+        /// @{
+        /**
+         * @brief FSM copy and move functions
+         *
+         * The FSM only stores pointers to the static state instances, so copies and moves are
+         * independent FSMs in the same state. This allows to store FSMs in contiguous containers.
+         */
+        FSM(const FSM&) = default;
+        FSM(FSM&&) noexcept = default;
+        FSM& operator=(const FSM&) = default;
+        FSM& operator=(FSM&&) noexcept = default;
+        /// @}
+
         /**
          * @brief additional function called on reset
          */
@@ -204,14 +850,33 @@ namespace scriptsizefsm {
         /**
          * \internal
          * @brief pointer to FSM implementation
+         *
+         * Derived on every call instead of stored, so that copied and moved FSMs stay valid.
          */
-        T_FSM_Child* this_;
-
+        inline T_FSM_Child* self()
+        {
+            return static_cast<T_FSM_Child*>(this);
+        }
+
+        /**
+         * \internal
+         * @brief dispatches an event to the current state, used by the run-to-completion queue
+         */
+        template<class T_Event>
+        static void dispatch(void* const fsm, const void* const event)
+        {
+            auto* const child = static_cast<T_FSM_Child*>(fsm);
+            FSM* const base = child;
+            const auto& typed_event = *static_cast<const T_Event*>(event);
+            base->tracer().on_react(*child, base->current_state_, typed_event);
+            base->current_state_->react(child, typed_event);
+        }
+
         /**
          * \internal
          * @brief pointer to the initial state
          */
-        const T_State_Generic* const init_state_;
+        const T_State_Generic* init_state_;
 
         /**
          * \internal
@@ -220,6 +885,1201 @@ namespace scriptsizefsm {
         const T_State_Generic* current_state_;
     };
 
+    /**
+     * \internal
+     * @brief calls a function object with the type tag and the index of each type of a list
+     */
+    template<class T_List, class T_Func>
+    constexpr void _for_each_index(T_Func&& func)
+    {
+        _for_each_index_impl(
+            T_List {}, std::make_index_sequence<T_List::size> {}, std::forward<T_Func>(func)
+        );
+    }
+
+    /// @{
+    /**
+     * \internal
+     * @brief non-virtual state function call helpers
+     *
+     * If the reaction of a state to an event is declared with the exact signature in the state
+     * (or the class name lookup ends in), the call is qualified and thus non-virtual and can be
+     * inlined. Otherwise the reaction is hidden by another overload and the call goes through
+     * the generic state, where the compiler can still devirtualize it since the object is known.
+     */
+    template<class T_FSM, class T_Event, class T_Class>
+    T_Class* _react_class(void (T_Class::*)(T_FSM* const, const T_Event&) const);
+
+    template<class T_State, class T_FSM, class T_Event, class = void>
+    struct _declares_react : std::false_type {};
+
+    template<class T_State, class T_FSM, class T_Event>
+    struct _declares_react<
+        T_State,
+        T_FSM,
+        T_Event,
+        std::void_t<decltype(_react_class<T_FSM, T_Event>(&T_State::react))>> : std::true_type {
+        using type = std::remove_pointer_t<decltype(_react_class<T_FSM, T_Event>(&T_State::react))>;
+    };
+
+    template<class T_State_Generic, class T_State, class T_FSM, class T_Event>
+    constexpr void _state_react(T_FSM* const fsm, const T_Event& event)
+    {
+        const T_State& state = _state_instance<T_State>::value;
+        if constexpr(_declares_react<T_State, T_FSM, T_Event>::value) {
+            state.T_State::react(fsm, event);
+        } else {
+            static_cast<const T_State_Generic&>(state).react(fsm, event);
+        }
+    }
+
+    /// @}
+
+    /**
+     * \internal
+     * @brief checks if a state overrides the reaction of the generic state to an event
+     *
+     * The class declaring the reaction found by name lookup in the state tells at compile time.
+     * A reaction hidden by other overloads declared in the state counts as not overridden, so an
+     * intermediate base class overriding it has to be re-exposed with `using Base::react;`.
+     */
+    template<class T_State_Generic, class T_State, class T_FSM, class T_Event>
+    constexpr bool _state_handles()
+    {
+        if constexpr(_declares_react<T_State, T_FSM, T_Event>::value) {
+            using T_Class = typename _declares_react<T_State, T_FSM, T_Event>::type;
+            return !std::is_base_of_v<T_Class, T_State_Generic>;
+        } else {
+            return false;
+        }
+    }
+
+    /// @{
+    /**
+     * \internal
+     * @brief hierarchical state helpers
+     *
+     * A state declares its parent state with `using parent = ParentState;` and a state with
+     * children can declare the child that is entered with it with `using initial = ChildState;`.
+     * States without parent are at the top of the hierarchy. Everything is resolved at compile
+     * time, so that every state dispatches and transits like in a flat FSM.
+     */
+    template<class T_State, class = void>
+    struct _parent_of {
+        using type = void;
+    };
+
+    template<class T_State>
+    struct _parent_of<T_State, std::void_t<typename T_State::parent>> {
+        using type = typename T_State::parent;
+    };
+
+    template<class T_State, class = void>
+    struct _initial_of {
+        using type = void;
+    };
+
+    template<class T_State>
+    struct _initial_of<T_State, std::void_t<typename T_State::initial>> {
+        using type = typename T_State::initial;
+    };
+
+    template<class... T_States>
+    constexpr bool _is_hierarchical(TypeList<T_States...>)
+    {
+        return (!std::is_void_v<typename _parent_of<T_States>::type> || ...);
+    }
+
+    /**
+     * \internal
+     * @brief state that is entered when transiting to a state, following the initial children
+     */
+    template<class T_State, class T_Initial = typename _initial_of<T_State>::type>
+    struct _target_of {
+        using type = typename _target_of<T_Initial>::type;
+    };
+
+    template<class T_State>
+    struct _target_of<T_State, void> {
+        using type = T_State;
+    };
+
+    /**
+     * \internal
+     * @brief checks if a state is a proper ancestor of another state
+     */
+    template<class T_Ancestor, class T_State>
+    constexpr bool _is_ancestor()
+    {
+        using T_Parent = typename _parent_of<T_State>::type;
+        if constexpr(std::is_void_v<T_Parent>) {
+            return false;
+        } else {
+            return std::is_same_v<T_Parent, T_Ancestor> || _is_ancestor<T_Ancestor, T_Parent>();
+        }
+    }
+
+    /**
+     * \internal
+     * @brief innermost state that is left by neither the exit nor the entry path of a transition
+     *
+     * That is the innermost ancestor of the source state, or the source state itself, that is a
+     * proper ancestor of the target state, `void` if there is none. A transition to the source
+     * state itself or to one of its ancestors thus exits and enters that state again.
+     */
+    template<class T_State, class T_Target>
+    struct _transit_domain {
+        using type = std::conditional_t<
+            _is_ancestor<T_State, T_Target>(),
+            T_State,
+            typename _transit_domain<typename _parent_of<T_State>::type, T_Target>::type>;
+    };
+
+    template<class T_Target>
+    struct _transit_domain<void, T_Target> {
+        using type = void;
+    };
+
+    /**
+     * \internal
+     * @brief calls the exit functions from a state up to, but excluding, an ancestor
+     */
+    template<class T_State, class T_Ancestor, class T_FSM>
+    constexpr void _exit_to(T_FSM* const fsm)
+    {
+        if constexpr(!std::is_void_v<T_State> && !std::is_same_v<T_State, T_Ancestor>) {
+            _state_exit<T_State>(fsm);
+            _exit_to<typename _parent_of<T_State>::type, T_Ancestor>(fsm);
+        }
+    }
+
+    /**
+     * \internal
+     * @brief calls the entry functions from below an ancestor down to a state and then down
+     * its initial children
+     */
+    template<class T_Ancestor, class T_State, class T_FSM>
+    constexpr void _enter_from(T_FSM* const fsm)
+    {
+        if constexpr(!std::is_void_v<T_State> && !std::is_same_v<T_State, T_Ancestor>) {
+            _enter_from<T_Ancestor, typename _parent_of<T_State>::type>(fsm);
+            _state_entry<T_State>(fsm);
+        }
+    }
+
+    template<class T_State, class T_FSM>
+    constexpr void _enter_initial(T_FSM* const fsm)
+    {
+        using T_Initial = typename _initial_of<T_State>::type;
+        if constexpr(!std::is_void_v<T_Initial>) {
+            _state_entry<T_Initial>(fsm);
+            _enter_initial<T_Initial>(fsm);
+        }
+    }
+
+    /**
+     * \internal
+     * @brief checks if a state or one of its ancestors handles an event
+     */
+    template<class T_State_Generic, class T_State, class T_FSM, class T_Event>
+    constexpr bool _hierarchy_handles()
+    {
+        if constexpr(std::is_void_v<T_State>) {
+            return false;
+        } else {
+            return _state_handles<T_State_Generic, T_State, T_FSM, T_Event>() ||
+                   _hierarchy_handles<
+                       T_State_Generic,
+                       typename _parent_of<T_State>::type,
+                       T_FSM,
+                       T_Event>();
+        }
+    }
+
+    /**
+     * \internal
+     * @brief calls the reaction of the innermost state from a state upwards that handles an
+     * event, the reaction of the state itself if none does
+     */
+    template<class T_State_Generic, class T_State, class T_Handler, class T_FSM, class T_Event>
+    constexpr void _hierarchy_react(T_FSM* const fsm, const T_Event& event)
+    {
+        using T_Parent = typename _parent_of<T_Handler>::type;
+        if constexpr(std::is_void_v<typename _parent_of<T_State>::type>) {
+            _state_react<T_State_Generic, T_State>(fsm, event);
+        } else if constexpr(_state_handles<T_State_Generic, T_Handler, T_FSM, T_Event>()) {
+            _state_react<T_State_Generic, T_Handler>(fsm, event);
+        } else if constexpr(std::is_void_v<T_Parent>) {
+            _state_react<T_State_Generic, T_State>(fsm, event);
+        } else {
+            _hierarchy_react<T_State_Generic, T_State, T_Parent>(fsm, event);
+        }
+    }
+    /// @}
+
+    /**
+     * @brief transition target entering a state with history and its last active child
+     * @tparam T_State state with history
+     *
+     * A state records its history if it declares `static constexpr bool history = true;`. Then
+     * `transit<ShallowHistory<T_State>>()` enters the child of the state that was active when the
+     * state was exited last, and the initial children of that child. If the state was not
+     * exited since the start or the last reset, its initial children are entered.
+     */
+    template<class T_State>
+    struct ShallowHistory {};
+
+    /**
+     * @brief transition target entering a state with history and its last active descendant
+     * @tparam T_State state with history
+     *
+     * Like `ShallowHistory`, but enters the innermost state that was active when the state was
+     * exited last, and all states between.
+     */
+    template<class T_State>
+    struct DeepHistory {};
+
+    /// @{
+    /**
+     * \internal
+     * @brief history helpers
+     *
+     * For each state with history, the index of the innermost state that was active when it was
+     * exited last is stored in the FSM, initially the index of the state itself. Both the shallow
+     * and the deep history are derived from it at compile time, so that restoring it is a switch
+     * over that index.
+     */
+    template<class T_State, class = void>
+    struct _has_history : std::false_type {};
+
+    template<class T_State>
+    struct _has_history<T_State, std::void_t<decltype(T_State::history)>>
+      : std::bool_constant<T_State::history> {};
+
+    template<class T_Target>
+    struct _history_of {
+        using type = void;
+        static constexpr bool deep = false;
+    };
+
+    template<class T_State>
+    struct _history_of<ShallowHistory<T_State>> {
+        using type = T_State;
+        static constexpr bool deep = false;
+    };
+
+    template<class T_State>
+    struct _history_of<DeepHistory<T_State>> {
+        using type = T_State;
+        static constexpr bool deep = true;
+    };
+
+    template<class... T_States>
+    constexpr std::size_t _history_count(TypeList<T_States...>)
+    {
+        return (std::size_t {0} + ... + (_has_history<T_States>::value ? 1U : 0U));
+    }
+
+    /**
+     * \internal
+     * @brief position of the stored history of a state among all states with history
+     */
+    template<class T_State, class... T_States>
+    constexpr std::size_t _history_slot(TypeList<T_States...>)
+    {
+        constexpr bool has_history[] = {_has_history<T_States>::value..., false};
+        std::size_t slot = 0;
+        for(std::size_t state = 0; state < index_of<T_State, TypeList<T_States...>>; ++state) {
+            slot += has_history[state] ? 1U : 0U;
+        }
+        return slot;
+    }
+
+    /**
+     * \internal
+     * @brief child of an ancestor that is a state or one of its ancestors, the state itself if it
+     * is the ancestor
+     */
+    template<class T_Ancestor, class T_State>
+    struct _child_toward {
+        using T_Parent = typename _parent_of<T_State>::type;
+        using type = std::conditional_t<
+            std::is_same_v<T_State, T_Ancestor> || std::is_same_v<T_Parent, T_Ancestor>,
+            T_State,
+            typename _child_toward<T_Ancestor, T_Parent>::type>;
+    };
+
+    template<class T_Ancestor>
+    struct _child_toward<T_Ancestor, void> {
+        using type = void;
+    };
+    /// @}
+
+    /**
+     * @brief how the FSMs storing the index of the current state implement `transit`
+     *
+     * An FSM implementation opts in to a mode by declaring a public member
+     * `static constexpr scriptsizefsm::TransitMode transit_mode`.
+     */
+    enum class TransitMode
+    {
+        /**
+         * @brief calls the exit function of the current state through a switch over its index,
+         * the default
+         */
+        dispatch,
+
+        /**
+         * @brief calls a function generated for the pair of current and next state, which
+         * contains the exit function, the store of the index and the entry function
+         */
+        thunks,
+    };
+
+    /**
+     * \internal
+     * @brief transit mode declared by a FSM implementation, `TransitMode::dispatch` if none
+     */
+    template<class T_FSM, class = void>
+    struct _transit_mode : std::integral_constant<TransitMode, TransitMode::dispatch> {};
+
+    template<class T_FSM>
+    struct _transit_mode<T_FSM, std::void_t<decltype(T_FSM::transit_mode)>>
+      : std::integral_constant<TransitMode, T_FSM::transit_mode> {};
+
+    /**
+     * \internal
+     * @brief storage of the history of the states with history inside the FSM instance
+     */
+    template<class T_Index, std::size_t N_History>
+    class _history_storage {
+
+      protected:
+
+        constexpr T_Index& history(std::size_t slot)
+        {
+            return history_[slot];
+        }
+
+      private:
+
+        T_Index history_[N_History] {};
+    };
+
+    template<class T_Index>
+    class _history_storage<T_Index, 0> {};
+
+    /**
+     * \internal
+     * @brief storage of the current state index inside the FSM instance
+     */
+    template<class T_Index, std::size_t N_History = 0>
+    class _index_storage : public _history_storage<T_Index, N_History> {
+
+      protected:
+
+        constexpr _index_storage(T_Index init_state)
+          : current_state_(init_state) {};
+
+        constexpr T_Index& current_state()
+        {
+            return current_state_;
+        }
+
+        constexpr const T_Index& current_state() const
+        {
+            return current_state_;
+        }
+
+      private:
+
+        T_Index current_state_;
+    };
+
+    /**
+     * \internal
+     * @brief storage of the current state index and the history of the states of a state list
+     */
+    template<class T_State_List>
+    using _state_storage =
+        _index_storage<_index_type<T_State_List::size>, _history_count(T_State_List {})>;
+
+    /**
+     * \internal
+     * @brief common part of the FSMs storing the index of the current state
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_State_Generic class of the generic state containing all reactions
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_Storage class providing `current_state()`, the storage of the current state index
+     * @tparam T_Tracer tracing policy, see `NoTracer`
+     *
+     * Reactions are dispatched through a switch over the index of the current state, calling the
+     * state functions non-virtually so that they can be inlined.
+     */
+    template<
+        class T_FSM_Child,
+        class T_State_Generic,
+        class T_State_List,
+        class T_Storage = _state_storage<T_State_List>,
+        class T_Tracer = NoTracer>
+    class _index_fsm
+      : public T_Storage,
+        protected T_Tracer {
+
+        friend State<T_FSM_Child>;
+
+      public:
+
+        /**
+         * @brief list of all states of the FSM
+         */
+        using state_list = T_State_List;
+
+        /**
+         * @brief smallest unsigned type that can hold the index of any state
+         */
+        using index_type = _index_type<T_State_List::size>;
+
+        /**
+         * @brief reacts to a given event
+         * @tparam T_Event event class to react to
+         * @param event event to react to
+         * @note T_State_Generic needs to have a react function for the event
+         */
+        template<class T_Event>
+        inline void react(const T_Event& event)
+        {
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            _rtc_react(&current_state(), fsm, &dispatch<T_Event>, event);
+        }
+
+        /**
+         * \internal
+         * @brief reacts to a given event, knowing that the FSM is in a given state
+         * @tparam T_State state the FSM is currently in
+         * @tparam T_Event event class to react to
+         * @param event event to react to
+         */
+        template<class T_State, class T_Event>
+        inline void _react_in(const T_Event& event)
+        {
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            _rtc_react(&current_state(), fsm, &dispatch<T_Event>, event, [fsm, &event]() {
+                state_react<T_State>(fsm, event);
+            });
+        }
+
+        /**
+         * \internal
+         * @brief reacts to a given event as one FSM of a batch, see `_rtc_react`
+         * @param batch run-to-completion context of the batch
+         * @param event event to react to
+         */
+        template<class T_Event>
+        inline void _react_batched(_rtc_context& batch, const T_Event& event)
+        {
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            _rtc_react(batch, &current_state(), fsm, &dispatch<T_Event>, event, [fsm, &event]() {
+                dispatch<T_Event>(fsm, &event);
+            });
+        }
+
+        /**
+         * \internal
+         * @brief reacts to a given event as one FSM of a batch, knowing its current state
+         */
+        template<class T_State, class T_Event>
+        inline void _react_in(_rtc_context& batch, const T_Event& event)
+        {
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            _rtc_react(batch, &current_state(), fsm, &dispatch<T_Event>, event, [fsm, &event]() {
+                state_react<T_State>(fsm, event);
+            });
+        }
+
+        /**
+         * @brief checks if the FSM is in a given state
+         * @tparam state to check for
+         * @return bool that is true if FSM is in given state
+         */
+        template<class T_State>
+        constexpr bool is_in_state() const
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            return current_state() == index_of<T_State, state_list>;
+        }
+
+        /**
+         * @brief index of the current state in the state list
+         */
+        constexpr index_type state_id() const
+        {
+            return current_state();
+        }
+
+        /// @{
+        /**
+         * @brief tracer of the FSM
+         */
+        constexpr T_Tracer& tracer()
+        {
+            return *this;
+        }
+
+        constexpr const T_Tracer& tracer() const
+        {
+            return *this;
+        }
+        /// @}
+
+      protected:
+
+        /**
+         * @brief FSM state transition function
+         * @tparam state to transition to
+         */
+        template<class T_State>
+        constexpr void transit()
+        {
+            using T_History = _history_of<T_State>;
+            static_assert(
+                _index_of<T_State, state_list>::found || !std::is_void_v<typename T_History::type>,
+                "state not in state list"
+            );
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            if constexpr(!std::is_void_v<typename T_History::type>) {
+                transit_history<typename T_History::type, T_History::deep>();
+            } else if constexpr(_transit_mode<T_FSM_Child>::value == TransitMode::thunks) {
+                transit_thunks<T_State>(state_list {})[current_state()](fsm);
+            } else if constexpr(_is_hierarchical(state_list {})) {
+                _visit<state_list>(current_state(), [fsm](auto tag) {
+                    transit_thunk<typename decltype(tag)::type, T_State>(fsm);
+                });
+            } else {
+                const index_type from = current_state();
+                exit_current();
+                current_state() = index_of<T_State, state_list>;
+                tracer().on_transit(*fsm, from, current_state());
+                _state_entry<T_State>(fsm);
+            }
+        }
+
+        /**
+         * \internal
+         * @brief constructor
+         * @param args arguments for the storage of the current state index
+         */
+        template<typename... T_Arg>
+        constexpr _index_fsm(T_Arg... args)
+          : T_Storage(args...)
+        {
+            clear_history();
+        }
+
+        using T_Storage::current_state;
+
+        /**
+         * \internal
+         * @brief calls the exit function of the current state and of all its ancestors
+         *
+         * Nothing is dispatched if no state overrides its exit function, so that a transition
+         * between states without entry and exit functions is a single store.
+         */
+        constexpr void exit_current()
+        {
+            if constexpr(_any_overrides_exit<T_FSM_Child>(state_list {})) {
+                auto* const fsm = static_cast<T_FSM_Child*>(this);
+                _visit<state_list>(current_state(), [fsm](auto tag) {
+                    _exit_to<typename decltype(tag)::type, void>(fsm);
+                });
+            }
+        }
+
+        /**
+         * \internal
+         * @brief calls the entry function of all ancestors of the current state and of the state
+         */
+        constexpr void entry_current()
+        {
+            if constexpr(_any_overrides_entry<T_FSM_Child>(state_list {})) {
+                auto* const fsm = static_cast<T_FSM_Child*>(this);
+                _visit<state_list>(current_state(), [fsm](auto tag) {
+                    _enter_from<void, typename decltype(tag)::type>(fsm);
+                });
+            }
+        }
+
+        /**
+         * \internal
+         * @brief forgets the history of all states with history
+         */
+        constexpr void clear_history()
+        {
+            if constexpr(_history_count(state_list {}) != 0) {
+                _for_each_index<state_list>([this](auto tag, std::size_t state) {
+                    using T_State = typename decltype(tag)::type;
+                    if constexpr(_has_history<T_State>::value) {
+                        this->history(_history_slot<T_State>(state_list {})) =
+                            static_cast<index_type>(state);
+                    }
+                });
+            }
+        }
+
+        /**
+         * \internal
+         * @brief lets the current state react to an event, without run-to-completion semantics
+         */
+        template<class T_Event>
+        constexpr void react_current(const T_Event& event)
+        {
+            auto* const fsm = static_cast<T_FSM_Child*>(this);
+            _visit<state_list>(current_state(), [fsm, &event](auto tag) {
+                state_react<typename decltype(tag)::type>(fsm, event);
+            });
+        }
+
+        /**
+         * \internal
+         * @brief runs a function with run-to-completion semantics, e.g. a reset
+         */
+        template<class T_Func>
+        inline void run_to_completion(T_Func&& func)
+        {
+            _rtc_run(&current_state(), static_cast<T_FSM_Child*>(this), func);
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief transition from one given state to another, see `TransitMode::thunks`
+         *
+         * In a hierarchy, the states from the source state up to the transition domain are
+         * exited, then the states from below the domain down to the target state and its initial
+         * children are entered.
+         */
+        template<class T_From, class T_To>
+        static constexpr void transit_thunk(T_FSM_Child* const fsm)
+        {
+            using T_Domain = typename _transit_domain<T_From, T_To>::type;
+            using T_Target = typename _target_of<T_To>::type;
+            static_assert(_index_of<T_Target, state_list>::found, "state not in state list");
+            _index_fsm* const base = fsm;
+            constexpr index_type from = index_of<T_From, state_list>;
+            _exit_to<T_From, T_Domain>(fsm);
+            base->template record_history<T_From, T_From, T_Domain>();
+            base->current_state() = index_of<T_Target, state_list>;
+            base->tracer().on_transit(*fsm, from, base->current_state());
+            _enter_from<T_Domain, T_To>(fsm);
+            _enter_initial<T_To>(fsm);
+        }
+
+        /**
+         * \internal
+         * @brief stores a state as the history of the exited states with history, from a state up
+         * to, but excluding, an ancestor
+         */
+        template<class T_Last, class T_State, class T_Ancestor>
+        constexpr void record_history()
+        {
+            if constexpr(!std::is_void_v<T_State> && !std::is_same_v<T_State, T_Ancestor>) {
+                if constexpr(_has_history<T_State>::value) {
+                    this->history(_history_slot<T_State>(state_list {})) =
+                        index_of<T_Last, state_list>;
+                }
+                record_history<T_Last, typename _parent_of<T_State>::type, T_Ancestor>();
+            }
+        }
+
+        /**
+         * \internal
+         * @brief transition to a state with history, see `ShallowHistory` and `DeepHistory`
+         *
+         * Switches over the stored history to the transition to the state to resume, which then
+         * is a transition to a known state.
+         */
+        template<class T_State, bool N_Deep>
+        constexpr void transit_history()
+        {
+            static_assert(_index_of<T_State, state_list>::found, "state not in state list");
+            static_assert(_has_history<T_State>::value, "state has no history");
+            constexpr std::size_t slot = _history_slot<T_State>(state_list {});
+            _visit<state_list>(this->history(slot), [this](auto tag) {
+                using T_Last = typename decltype(tag)::type;
+                if constexpr(std::is_same_v<T_Last, T_State> || _is_ancestor<T_State, T_Last>()) {
+                    using T_Resume = std::conditional_t<
+                        N_Deep,
+                        T_Last,
+                        typename _child_toward<T_State, T_Last>::type>;
+                    transit<T_Resume>();
+                }
+            });
+        }
+
+        /**
+         * \internal
+         * @brief table of the transitions from each state to a given state, indexed by state
+         */
+        template<class T_To, class... T_From>
+        static const auto* transit_thunks(StateList<T_From...>)
+        {
+            static constexpr void (*const thunks[])(T_FSM_Child* const) = {
+                &transit_thunk<T_From, T_To>...};
+            return thunks;
+        }
+
+        /**
+         * \internal
+         * @brief lets a state react to an event and reports it to the tracer
+         *
+         * If the state has no reaction to the event, the reaction of its innermost ancestor that
+         * has one is called.
+         */
+        template<class T_State, class T_Event>
+        static constexpr void state_react(T_FSM_Child* const fsm, const T_Event& event)
+        {
+            _index_fsm* const base = fsm;
+            constexpr index_type state = index_of<T_State, state_list>;
+            base->tracer().on_react(*fsm, state, event);
+            if constexpr(!_hierarchy_handles<T_State_Generic, T_State, T_FSM_Child, T_Event>()) {
+                base->tracer().on_unhandled(*fsm, state, event);
+            }
+            _hierarchy_react<T_State_Generic, T_State, T_State>(fsm, event);
+        }
+
+        /**
+         * \internal
+         * @brief dispatches an event to the current state, used by the run-to-completion queue
+         */
+        template<class T_Event>
+        static void dispatch(void* const fsm, const void* const event)
+        {
+            _index_fsm* const base = static_cast<T_FSM_Child*>(fsm);
+            base->react_current(*static_cast<const T_Event*>(event));
+        }
+    };
+
+    /**
+     * @brief Finite State Machine class with compile-time dispatch
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_State_Generic class of the generic state containing all reactions
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_Tracer tracing policy, see `NoTracer`
+     *
+     * Drop-in alternative to `FSM` with the same `react`, `transit`, `reset` and `is_in_state`
+     * API. Instead of a pointer to the current state, the index of the current state in the state
+     * list is stored. Reactions are dispatched through a switch over that index, calling the
+     * state functions non-virtually so that they can be inlined.
+     */
+    template<
+        class T_FSM_Child,
+        class T_State_Generic,
+        class T_State_List,
+        class T_Tracer = NoTracer>
+    class VariantFSM
+      : public _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _state_storage<T_State_List>,
+            T_Tracer> {
+
+        using _base = _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _state_storage<T_State_List>,
+            T_Tracer>;
+
+      public:
+
+        using typename _base::index_type;
+        using typename _base::state_list;
+
+        /**
+         * @brief starts the FSM
+         * @tparam T_State_Init initial state of the FSM
+         * @tparam T_Arg argument types for the FSM constructor
+         * @param args arguments for the FSM constructor
+         */
+        template<class T_State_Init, typename... T_Arg>
+        static T_FSM_Child start(T_Arg... args)
+        {
+            static_assert(_index_of<T_State_Init, state_list>::found, "state not in state list");
+            using T_Target = typename _target_of<T_State_Init>::type;
+            return T_FSM_Child {&_state_instance<T_Target>::value, args...};
+        }
+
+        /**
+         * @brief FSM default destructor
+         */
+        virtual ~VariantFSM() = default;
+
+        /**
+         * @brief resets the FSM
+         *
+         * This function exits the current state and enters the initial state.
+         */
+        void reset()
+        {
+            this->run_to_completion([this]() {
+                this->tracer().on_reset(*static_cast<T_FSM_Child*>(this));
+                this->exit_current();
+                this->current_state() = init_state_;
+                this->clear_history();
+                resetter();
+                this->entry_current();
+            });
+        };
+
+      protected:
+
+        /**
+         * @brief FSM constructor
+         * @param init_state initial state of the FSM
+         */
+        VariantFSM(const T_State_Generic* const init_state)
+          : _base(index_of_instance(init_state)),
+            init_state_(this->current_state()) {};
+
+        /**
+         * @brief additional function called on reset
+         */
+        virtual void resetter() {};
+
+      private:
+
+        /**
+         * \internal
+         * @brief looks up the index of a state instance in the state list
+         */
+        template<class... T_States>
+        static index_type
+        index_of_instance(const T_State_Generic* const state, StateList<T_States...>)
+        {
+            const T_State_Generic* const instances[] = {&_state_instance<T_States>::value...};
+            index_type index = 0;
+            while(index + 1U < sizeof...(T_States) && instances[index] != state) {
+                ++index;
+            }
+            return index;
+        }
+
+        static index_type index_of_instance(const T_State_Generic* const state)
+        {
+            return index_of_instance(state, state_list {});
+        }
+
+        /**
+         * \internal
+         * @brief index of the initial state
+         */
+        index_type init_state_;
+    };
+
+    /**
+     * @brief Finite State Machine class with compact storage
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_State_Generic class of the generic state containing all reactions
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_State_Init initial state of the FSM
+     * @tparam T_Tracer tracing policy, see `NoTracer`
+     *
+     * Like `VariantFSM`, but without virtual functions and with the initial state fixed at compile
+     * time. The only data stored per instance is the index of the current state, which is a single
+     * byte for up to 256 states. Since there is no virtual `resetter`, the FSM implementation can
+     * hide `resetter()` instead of overriding it.
+     */
+    template<
+        class T_FSM_Child,
+        class T_State_Generic,
+        class T_State_List,
+        class T_State_Init,
+        class T_Tracer = NoTracer>
+    class CompactFSM
+      : public _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _state_storage<T_State_List>,
+            T_Tracer> {
+
+        using _base = _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _state_storage<T_State_List>,
+            T_Tracer>;
+
+      public:
+
+        using typename _base::index_type;
+        using typename _base::state_list;
+
+        static_assert(_index_of<T_State_Init, T_State_List>::found, "state not in state list");
+
+        /**
+         * @brief index of the initial state, or of the state entered with it if it has children
+         */
+        static constexpr index_type init_state =
+            index_of<typename _target_of<T_State_Init>::type, T_State_List>;
+
+        /**
+         * @brief starts the FSM
+         * @tparam T_State_Init_Start initial state of the FSM, has to match T_State_Init
+         * @tparam T_Arg argument types for the FSM constructor
+         * @param args arguments for the FSM constructor
+         */
+        template<class T_State_Init_Start = T_State_Init, typename... T_Arg>
+        static T_FSM_Child start(T_Arg... args)
+        {
+            static_assert(
+                std::is_same_v<T_State_Init_Start, T_State_Init>, "initial state is fixed"
+            );
+            return T_FSM_Child {args...};
+        }
+
+        /**
+         * @brief resets the FSM
+         *
+         * This function exits the current state and enters the initial state.
+         */
+        void reset()
+        {
+            this->run_to_completion([this]() {
+                this->tracer().on_reset(*static_cast<T_FSM_Child*>(this));
+                this->exit_current();
+                this->current_state() = init_state;
+                this->clear_history();
+                static_cast<T_FSM_Child*>(this)->resetter();
+                this->entry_current();
+            });
+        };
+
+      protected:
+
+        /**
+         * @brief FSM constructor
+         */
+        CompactFSM()
+          : _base(init_state) {};
+
+        /**
+         * @brief additional function called on reset
+         *
+         * Hide this function in the FSM implementation to run code on reset.
+         */
+        void resetter() {};
+    };
+
+    /**
+     * @brief State class of `ConstexprFSM`
+     * @tparam T_FSM class to the FSM implementation
+     *
+     * Like `State`, but without virtual functions, so that states are literal types and their
+     * functions can be `constexpr`. A state declares the reactions it handles, all other
+     * reactions are taken from the generic state. Entry and exit functions are hidden, not
+     * overridden, in the states.
+     */
+    template<class T_FSM>
+    class ConstexprState {
+
+      public:
+
+        /**
+         * @brief entry function of a state
+         * @param fsm pointer to the FSM
+         */
+        constexpr void entry(T_FSM* const fsm) const {};
+
+        /**
+         * @brief exit function of a state
+         * @param fsm pointer to the FSM
+         */
+        constexpr void exit(T_FSM* const fsm) const {};
+
+      protected:
+
+        /**
+         * @brief state transition helper function
+         * @tparam T_State state to transition to
+         */
+        template<class T_State>
+        constexpr void transit(T_FSM* const fsm) const
+        {
+            fsm->template transit<T_State>();
+        }
+    };
+
+    /**
+     * @brief Finite State Machine class that can be evaluated at compile time
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     * @tparam T_State_Generic class of the generic state containing all reactions, derived from
+     * `ConstexprState`
+     * @tparam T_State_List `StateList` of all states the FSM can be in
+     * @tparam T_State_Init initial state of the FSM
+     * @tparam T_Tracer tracing policy, see `NoTracer`
+     *
+     * Like `CompactFSM`, but `start`, `react`, `reset`, `transit` and `is_in_state` are
+     * `constexpr`. If the FSM implementation is a literal type with `constexpr` functions and
+     * states, a `static_assert` can replay a sequence of events and instances can be constant
+     * initialized, see `SCRIPTSIZEFSM_CONSTINIT`. Since the run-to-completion queue cannot be
+     * used at compile time, events raised during a reaction are dispatched immediately.
+     */
+    template<
+        class T_FSM_Child,
+        class T_State_Generic,
+        class T_State_List,
+        class T_State_Init,
+        class T_Tracer = NoTracer>
+    class ConstexprFSM
+      : public _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _state_storage<T_State_List>,
+            T_Tracer> {
+
+        friend ConstexprState<T_FSM_Child>;
+
+        using _base = _index_fsm<
+            T_FSM_Child,
+            T_State_Generic,
+            T_State_List,
+            _state_storage<T_State_List>,
+            T_Tracer>;
+
+      public:
+
+        using typename _base::index_type;
+        using typename _base::state_list;
+
+        static_assert(_index_of<T_State_Init, T_State_List>::found, "state not in state list");
+
+        /**
+         * @brief index of the initial state, or of the state entered with it if it has children
+         */
+        static constexpr index_type init_state =
+            index_of<typename _target_of<T_State_Init>::type, T_State_List>;
+
+        /**
+         * @brief table of the state after a reaction, indexed by state and event
+         */
+        template<class T_Event_List>
+        using next_state_table_type =
+            std::array<std::array<index_type, T_Event_List::size>, T_State_List::size>;
+
+        /**
+         * @brief starts the FSM
+         * @tparam T_State_Init_Start initial state of the FSM, has to match T_State_Init
+         * @tparam T_Arg argument types for the FSM constructor
+         * @param args arguments for the FSM constructor
+         */
+        template<class T_State_Init_Start = T_State_Init, typename... T_Arg>
+        static constexpr T_FSM_Child start(T_Arg... args)
+        {
+            static_assert(
+                std::is_same_v<T_State_Init_Start, T_State_Init>, "initial state is fixed"
+            );
+            return T_FSM_Child {args...};
+        }
+
+        /**
+         * @brief reacts to a given event
+         * @tparam T_Event event class to react to
+         * @param event event to react to
+         */
+        template<class T_Event>
+        constexpr void react(const T_Event& event)
+        {
+            this->react_current(event);
+        }
+
+        /**
+         * @brief resets the FSM
+         *
+         * This function exits the current state and enters the initial state.
+         */
+        constexpr void reset()
+        {
+            this->tracer().on_reset(*static_cast<T_FSM_Child*>(this));
+            this->exit_current();
+            this->current_state() = init_state;
+            this->clear_history();
+            static_cast<T_FSM_Child*>(this)->resetter();
+            this->entry_current();
+        };
+
+        /**
+         * @brief computes the state after each state reacted to each event
+         * @tparam T_Event_List `EventList` of the events, which have to be default constructible
+         * @param args arguments for the FSM constructor
+         * @return table of the index of the next state, indexed by state and event index
+         *
+         * For every pair, a FSM is constructed with the given arguments and put directly into the
+         * state, without entry function, before it reacts to a default constructed event. The
+         * table is thus only exact if the transitions depend on the state and the event type
+         * alone. Evaluated at compile time, it can be stored as `constexpr` or constant initialized
+         * data for table-based dispatch.
+         */
+        template<class T_Event_List, typename... T_Arg>
+        static constexpr next_state_table_type<T_Event_List> next_state_table(T_Arg... args)
+        {
+            next_state_table_type<T_Event_List> table {};
+            for(std::size_t state = 0; state < T_State_List::size; ++state) {
+                _for_each_index<T_Event_List>([&](auto tag, std::size_t event) {
+                    T_FSM_Child fsm {args...};
+                    fsm.current_state() = static_cast<index_type>(state);
+                    fsm.react(typename decltype(tag)::type {});
+                    table[state][event] = fsm.current_state();
+                });
+            }
+            return table;
+        }
+
+        /**
+         * @brief computes which states can be reached from the initial state
+         * @tparam T_Event_List `EventList` of the events, which have to be default constructible
+         * @param args arguments for the FSM constructor
+         * @return array that is true for each state reachable through the `next_state_table`
+         */
+        template<class T_Event_List, typename... T_Arg>
+        static constexpr std::array<bool, T_State_List::size> reachable_states(T_Arg... args)
+        {
+            const auto table = next_state_table<T_Event_List>(args...);
+            std::array<bool, T_State_List::size> reachable {};
+            reachable[init_state] = true;
+            for(bool changed = true; changed;) {
+                changed = false;
+                for(std::size_t state = 0; state < T_State_List::size; ++state) {
+                    for(std::size_t event = 0; reachable[state] && event < T_Event_List::size;
+                        ++event) {
+                        const index_type next = table[state][event];
+                        changed = changed || !reachable[next];
+                        reachable[next] = true;
+                    }
+                }
+            }
+            return reachable;
+        }
+
+      protected:
+
+        /**
+         * @brief FSM constructor
+         */
+        constexpr ConstexprFSM()
+          : _base(init_state) {};
+
+        /**
+         * @brief additional function called on reset
+         *
+         * Hide this function in the FSM implementation to run code on reset.
+         */
+        constexpr void resetter() {};
+    };
+
     /**
      * @brief starts a FSM
      * @tparam T_FSM FSM implementation to start
@@ -228,7 +2088,7 @@ namespace scriptsizefsm {
      * @param args arguments for the FSM constructor
      */
     template<class T_FSM, class T_State_Init, typename... T_Arg>
-    T_FSM start(T_Arg... args)
+    constexpr T_FSM start(T_Arg... args)
     {
         return T_FSM::template start<T_State_Init, T_Arg...>(args...);
     };
@@ -0,0 +1,432 @@
+/**
+ * @file
+ * @brief Vectorized transition kernel for fleets driven by a pure transition table
+ *
+ * If the transitions of a machine depend only on the current state and the event, computing the
+ * next state is a byte-wise table lookup. The `TransitionKernel` compiles a `TransitionTable`
+ * into such a lookup table and advances a whole column of state indices through a column of event
+ * indices in one pass. With SSSE3 or AVX2 enabled, machines with up to 16 states use `pshufb` on
+ * 16 or 32 lanes at once, larger machines use AVX2 gathers. Otherwise a scalar loop is used.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "scriptsizefsm/fleet.hpp"
+#include "scriptsizefsm/scriptsizefsm.hpp"
+#include "scriptsizefsm/table.hpp"
+
+namespace scriptsizefsm {
+
+    /**
+     * \internal
+     * @brief compiles the rows of a transition table into a byte-wise next-state lookup table
+     */
+    template<class T_State_List, class T_Event_List>
+    struct _kernel_compiler {
+        static_assert(T_State_List::size <= 256, "state index has to fit into a byte");
+        static_assert(T_Event_List::size < 255, "event index has to fit into a byte");
+
+        // up to 16 states fill one register per event, larger tables keep padding for gathers
+        static constexpr std::size_t stride =
+            T_State_List::size <= 16 ? 16 : (T_State_List::size + 3 + 15) / 16 * 16;
+
+        // one row per event plus one identity row
+        struct alignas(32) table_type
+          : std::array<std::uint8_t, (T_Event_List::size + 1) * stride> {};
+
+        template<class T_Row>
+        static constexpr void insert_row(table_type& table)
+        {
+            using from = typename T_Row::from;
+            using event = typename T_Row::event;
+            using to =
+                std::conditional_t<std::is_void_v<typename T_Row::to>, from, typename T_Row::to>;
+            static_assert(T_Row::action == nullptr, "kernel tables can not contain actions");
+            static_assert(_index_of<from, T_State_List>::found, "state not in state list");
+            static_assert(_index_of<to, T_State_List>::found, "state not in state list");
+            static_assert(_index_of<event, T_Event_List>::found, "event not in event list");
+            table[index_of<event, T_Event_List> * stride + index_of<from, T_State_List>] =
+                static_cast<std::uint8_t>(index_of<to, T_State_List>);
+        }
+
+        template<class... T_Rows>
+        static constexpr table_type compile(TransitionTable<T_Rows...>)
+        {
+            static_assert(
+                _unique_rows<T_State_List, T_Event_List, T_Rows...>(),
+                "more than one row for the same state and event"
+            );
+            table_type table {};
+            for(std::size_t event = 0; event <= T_Event_List::size; ++event) {
+                for(std::size_t state = 0; state < T_State_List::size; ++state) {
+                    table[event * stride + state] = static_cast<std::uint8_t>(state);
+                }
+            }
+            (insert_row<T_Rows>(table), ...);
+            return table;
+        }
+    };
+
+    template<class T_State_List, class T_Event_List, class T_Table>
+    inline constexpr auto _compiled_kernel =
+        _kernel_compiler<T_State_List, T_Event_List>::compile(T_Table {});
+
+    /**
+     * @brief vectorized next-state computation for a transition table
+     * @tparam T_State_List `StateList` of all states, at most 256
+     * @tparam T_Event_List `EventList` of all events, at most 255
+     * @tparam T_Table `TransitionTable` without actions
+     *
+     * States and events are identified by their index in their list. Event indices outside of the
+     * event list, e.g. `no_event`, leave the state unchanged. Since the kernel only sees state
+     * indices, a row transiting into its own state behaves like an internal transition.
+     */
+    template<class T_State_List, class T_Event_List, class T_Table>
+    class TransitionKernel;
+
+    template<class... T_States, class... T_Events, class... T_Rows>
+    class TransitionKernel<
+        StateList<T_States...>,
+        EventList<T_Events...>,
+        TransitionTable<T_Rows...>> {
+
+      public:
+
+        /**
+         * @brief list of all states
+         */
+        using state_list = StateList<T_States...>;
+
+        /**
+         * @brief list of all events
+         */
+        using event_list = EventList<T_Events...>;
+
+        /**
+         * @brief event index that does not trigger any transition
+         */
+        static constexpr std::uint8_t no_event = UINT8_MAX;
+
+        /**
+         * @brief distance between two events in the lookup table
+         *
+         * Machines with up to 16 states use one 16 byte register per event. Larger machines keep
+         * three bytes of padding, so that 32 bit gathers never read past the end of the table.
+         */
+        static constexpr std::size_t stride = _kernel_compiler<state_list, event_list>::stride;
+
+        /**
+         * @brief type of the lookup table, one row per event plus one identity row
+         */
+        using table_type = typename _kernel_compiler<state_list, event_list>::table_type;
+
+        /**
+         * @brief compiled lookup table, indexed by `[event_id * stride + state_id]`
+         */
+        static constexpr const table_type& table()
+        {
+            return table_;
+        }
+
+        /**
+         * @brief next state for a single state and event
+         * @param state index of the current state
+         * @param event index of the event
+         * @return index of the next state
+         */
+        static constexpr std::uint8_t next_state(std::uint8_t state, std::uint8_t event)
+        {
+            return table_[row(event) + state];
+        }
+
+        /**
+         * @brief advances a state column through an event column
+         * @param states state index of each lane, updated in place
+         * @param events event index of each lane
+         * @param count number of lanes
+         * @param on_change called as `on_change(lane, from, to)` for each lane that changed state
+         */
+        template<class T_Func>
+        static void advance(
+            std::uint8_t* const states,
+            const std::uint8_t* const events,
+            std::size_t count,
+            T_Func&& on_change
+        )
+        {
+            std::size_t lane = 0;
+#if defined(__AVX2__)
+            if constexpr(state_list::size <= 16) {
+                lane = advance_shuffle_avx2(states, events, count, on_change);
+            } else {
+                lane = advance_gather_avx2(states, events, count, on_change);
+            }
+#elif defined(__SSSE3__)
+            if constexpr(state_list::size <= 16) {
+                lane = advance_shuffle_sse(states, events, count, on_change);
+            }
+#endif
+            const auto shifted = [&on_change, lane](auto index, auto from, auto to) {
+                on_change(lane + index, from, to);
+            };
+            advance_scalar(states + lane, events + lane, count - lane, shifted);
+        }
+
+        /**
+         * @brief advances a state column through an event column without callbacks
+         * @param states state index of each lane, updated in place
+         * @param events event index of each lane
+         * @param count number of lanes
+         */
+        static void advance(
+            std::uint8_t* const states,
+            const std::uint8_t* const events,
+            std::size_t count
+        )
+        {
+            advance(states, events, count, [](std::size_t, std::uint8_t, std::uint8_t) {});
+        }
+
+        /**
+         * @brief scalar version of `advance`, used for the remaining lanes
+         */
+        template<class T_Func>
+        static void advance_scalar(
+            std::uint8_t* const states,
+            const std::uint8_t* const events,
+            std::size_t count,
+            T_Func&& on_change
+        )
+        {
+            for(std::size_t lane = 0; lane < count; ++lane) {
+                const std::uint8_t from = states[lane];
+                const std::uint8_t to = next_state(from, events[lane]);
+                if(to != from) {
+                    states[lane] = to;
+                    on_change(lane, from, to);
+                }
+            }
+        }
+
+        /**
+         * @brief advances all FSMs of a fleet, calling the exit and entry functions of the states
+         * @param fleet fleet with the same state list as the kernel
+         * @param events event index of each FSM in the fleet
+         *
+         * The exit and entry functions are only called for FSMs that changed their state.
+         */
+        template<class T_FSM>
+        static void advance(Fleet<T_FSM>& fleet, const std::uint8_t* const events)
+        {
+            static_assert(
+                std::is_same_v<typename T_FSM::state_list, state_list>, "state lists differ"
+            );
+            std::uint8_t* const states = fleet.states();
+            advance(states, events, fleet.size(), [&fleet, states](auto lane, auto from, auto to) {
+                auto fsm = fleet[lane];
+                states[lane] = from;
+                _visit<state_list>(from, [&fsm](auto tag) {
+                    _state_exit<typename decltype(tag)::type>(&fsm);
+                });
+                states[lane] = to;
+                _visit<state_list>(to, [&fsm](auto tag) {
+                    _state_entry<typename decltype(tag)::type>(&fsm);
+                });
+            });
+        }
+
+      private:
+
+        /**
+         * \internal
+         * @brief offset of the row of an event, events outside of the list use the identity row
+         */
+        static constexpr std::size_t row(std::uint8_t event)
+        {
+            return (event < event_list::size ? event : event_list::size) * stride;
+        }
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+        /**
+         * \internal
+         * @brief pointer to the row of an event for unaligned 16 byte loads
+         */
+        static inline const __m128i* row_pointer(std::size_t event)
+        {
+            return reinterpret_cast<const __m128i*>(table_.data() + event * stride);
+        }
+#endif
+
+        /**
+         * \internal
+         * @brief calls the change callback for each set bit of a mask
+         */
+        template<class T_Func>
+        static inline void notify(
+            std::uint32_t changed,
+            std::size_t lane,
+            const std::uint8_t* const from,
+            const std::uint8_t* const states,
+            T_Func& on_change
+        )
+        {
+            while(changed != 0) {
+                const auto bit = _lowest_bit(changed);
+                on_change(lane + bit, from[bit], states[lane + bit]);
+                changed &= changed - 1;
+            }
+        }
+
+#if defined(__SSSE3__) && !defined(__AVX2__)
+        /**
+         * \internal
+         * @brief 16 lanes per step, shuffles the row of each event and keeps matching lanes
+         */
+        template<class T_Func>
+        static std::size_t advance_shuffle_sse(
+            std::uint8_t* const states,
+            const std::uint8_t* const events,
+            std::size_t count,
+            T_Func& on_change
+        )
+        {
+            std::size_t lane = 0;
+            for(; lane + 16 <= count; lane += 16) {
+                const __m128i from =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + lane));
+                const __m128i event =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(events + lane));
+                __m128i to = from;
+                for(std::size_t index = 0; index < event_list::size; ++index) {
+                    const __m128i row = _mm_loadu_si128(row_pointer(index));
+                    const __m128i match =
+                        _mm_cmpeq_epi8(event, _mm_set1_epi8(static_cast<char>(index)));
+                    to = _mm_or_si128(
+                        _mm_and_si128(match, _mm_shuffle_epi8(row, from)),
+                        _mm_andnot_si128(match, to)
+                    );
+                }
+                const auto unchanged = _mm_movemask_epi8(_mm_cmpeq_epi8(to, from));
+                const auto changed = ~static_cast<std::uint32_t>(unchanged) & 0xFFFFU;
+                if(changed != 0) {
+                    alignas(16) std::uint8_t old[16];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(old), from);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(states + lane), to);
+                    notify(changed, lane, old, states, on_change);
+                }
+            }
+            return lane;
+        }
+#endif
+
+#if defined(__AVX2__)
+        /**
+         * \internal
+         * @brief 32 lanes per step, shuffles the row of each event and keeps matching lanes
+         */
+        template<class T_Func>
+        static std::size_t advance_shuffle_avx2(
+            std::uint8_t* const states,
+            const std::uint8_t* const events,
+            std::size_t count,
+            T_Func& on_change
+        )
+        {
+            std::size_t lane = 0;
+            for(; lane + 32 <= count; lane += 32) {
+                const __m256i from =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + lane));
+                const __m256i event =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(events + lane));
+                __m256i to = from;
+                for(std::size_t index = 0; index < event_list::size; ++index) {
+                    const __m256i row =
+                        _mm256_broadcastsi128_si256(_mm_loadu_si128(row_pointer(index)));
+                    const __m256i match =
+                        _mm256_cmpeq_epi8(event, _mm256_set1_epi8(static_cast<char>(index)));
+                    to = _mm256_blendv_epi8(to, _mm256_shuffle_epi8(row, from), match);
+                }
+                const auto unchanged = _mm256_movemask_epi8(_mm256_cmpeq_epi8(to, from));
+                const auto changed = ~static_cast<std::uint32_t>(unchanged);
+                if(changed != 0) {
+                    alignas(32) std::uint8_t old[32];
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(old), from);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(states + lane), to);
+                    notify(changed, lane, old, states, on_change);
+                }
+            }
+            return lane;
+        }
+
+        /**
+         * \internal
+         * @brief 8 lanes per step, gathers the next state from the lookup table
+         */
+        template<class T_Func>
+        static std::size_t advance_gather_avx2(
+            std::uint8_t* const states,
+            const std::uint8_t* const events,
+            std::size_t count,
+            T_Func& on_change
+        )
+        {
+            const __m256i last_event = _mm256_set1_epi32(static_cast<int>(event_list::size));
+            const __m256i row_size = _mm256_set1_epi32(static_cast<int>(stride));
+            const __m256i byte_mask = _mm256_set1_epi32(UINT8_MAX);
+            std::size_t lane = 0;
+            for(; lane + 8 <= count; lane += 8) {
+                const __m128i from_bytes =
+                    _mm_loadl_epi64(reinterpret_cast<const __m128i*>(states + lane));
+                const __m256i from = _mm256_cvtepu8_epi32(from_bytes);
+                const __m256i event = _mm256_min_epu32(
+                    _mm256_cvtepu8_epi32(
+                        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(events + lane))
+                    ),
+                    last_event
+                );
+                const __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(event, row_size), from);
+                const __m256i to = _mm256_and_si256(
+                    _mm256_i32gather_epi32(reinterpret_cast<const int*>(table_.data()), offset, 1),
+                    byte_mask
+                );
+                const auto unchanged =
+                    _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(to, from)));
+                const auto changed = ~static_cast<std::uint32_t>(unchanged) & 0xFFU;
+                if(changed != 0) {
+                    // 32 bit lanes to bytes, packing works per 128 bit half
+                    const __m256i words =
+                        _mm256_permute4x64_epi64(_mm256_packus_epi32(to, to), 0b1000);
+                    const __m128i bytes = _mm_packus_epi16(
+                        _mm256_castsi256_si128(words), _mm256_castsi256_si128(words)
+                    );
+                    alignas(16) std::uint8_t old[16];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(old), from_bytes);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(states + lane), bytes);
+                    notify(changed, lane, old, states, on_change);
+                }
+            }
+            return lane;
+        }
+#endif
+
+        /**
+         * \internal
+         * @brief lookup table
+         */
+        static constexpr const table_type& table_ =
+            _compiled_kernel<state_list, event_list, TransitionTable<T_Rows...>>;
+    };
+
+}  // namespace scriptsizefsm
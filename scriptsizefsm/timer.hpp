@@ -0,0 +1,512 @@
+/**
+ * @file
+ * @brief Hierarchical timing wheel delivering state timeouts to many FSMs
+ *
+ * Timers are intrusive nodes stored inside the FSMs, so arming and cancelling a timer never
+ * allocates and only links or unlinks a node. The wheel has several levels of 64 slots each, a
+ * timer is placed in the level matching how far away its deadline is and moves down to finer
+ * levels as the wheel turns, so both arming and cancelling are O(1). Expired timers are fired in
+ * batches when the wheel is advanced, e.g. once per millisecond.
+ *
+ * All timers of a wheel share the callback of the wheel, so a timer is only four words. FSMs
+ * deriving from `Timed` receive a `Timeout` event when their timer expires, and states deriving
+ * from `TimeoutState` arm the timer on entry and cancel it on exit.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+namespace scriptsizefsm {
+
+    class TimerWheel;
+
+    /**
+     * @brief intrusive timer handle, stored inside the object that is notified
+     *
+     * A timer is armed on at most one wheel at a time. Timers can not be copied. Moving an armed
+     * timer relinks it in the wheel, so the moved-to timer stays armed and the moved-from one is
+     * not armed anymore. Timers are cancelled on destruction.
+     */
+    class Timer {
+
+        friend TimerWheel;
+
+      public:
+
+        /**
+         * @brief timer constructor
+         */
+        Timer() = default;
+
+        /**
+         * @brief timer constructor
+         * @param wheel wheel the timer is bound to until it is armed on another one
+         */
+        explicit Timer(TimerWheel& wheel)
+          : wheel_(&wheel) {};
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        Timer(Timer&& other) noexcept
+        {
+            take(other);
+        };
+
+        Timer& operator=(Timer&& other) noexcept
+        {
+            if(this != &other) {
+                cancel();
+                take(other);
+            }
+            return *this;
+        };
+
+        ~Timer()
+        {
+            cancel();
+        };
+
+        /**
+         * @brief checks if the timer is armed
+         */
+        inline bool armed() const
+        {
+            return link_ != nullptr;
+        }
+
+        /**
+         * @brief tick at which the timer expires, only meaningful while armed
+         */
+        inline std::uint64_t deadline() const
+        {
+            return deadline_;
+        }
+
+        /**
+         * @brief wheel the timer is bound to or was armed on last, `nullptr` if there is none
+         */
+        inline TimerWheel* wheel() const
+        {
+            return wheel_;
+        }
+
+        /**
+         * @brief cancels the timer if it is armed, O(1)
+         */
+        inline void cancel();
+
+      private:
+
+        /**
+         * \internal
+         * @brief takes over the wheel and, if armed, the place in the wheel of another timer
+         */
+        void take(Timer& other)
+        {
+            next_ = std::exchange(other.next_, nullptr);
+            link_ = std::exchange(other.link_, nullptr);
+            wheel_ = other.wheel_;
+            deadline_ = other.deadline_;
+            if(link_ != nullptr) {
+                *link_ = this;
+                if(next_ != nullptr) {
+                    next_->link_ = &next_;
+                }
+            }
+        }
+
+        /**
+         * \internal
+         * @brief next timer in the same slot
+         */
+        Timer* next_ {nullptr};
+
+        /**
+         * \internal
+         * @brief pointer pointing to this timer, nullptr if the timer is not armed
+         */
+        Timer** link_ {nullptr};
+
+        /**
+         * \internal
+         * @brief wheel the timer is bound to or was armed on last
+         */
+        TimerWheel* wheel_ {nullptr};
+
+        std::uint64_t deadline_ {0};
+    };
+
+    /**
+     * @brief hierarchical timing wheel
+     *
+     * Time is measured in ticks of arbitrary length. The wheel covers deadlines up to 2^48 ticks
+     * ahead with 8 levels of 64 slots, later deadlines wait in the coarsest level until they are in
+     * range. Advancing skips idle ticks, so its cost depends on the number of slots holding timers
+     * and not on the number of ticks. Timers expiring in the same tick are fired in no particular
+     * order. All timers of a wheel share one callback, e.g. `Timed<FSM>::expire` for the timeouts
+     * of one FSM class. The wheel is not thread-safe.
+     */
+    class TimerWheel {
+
+        friend Timer;
+
+      public:
+
+        /**
+         * @brief function called when a timer expires
+         */
+        using callback_type = void (*)(Timer& timer);
+
+        /**
+         * @brief wheel constructor
+         * @param expire function called when a timer of the wheel expires
+         * @param now current tick
+         */
+        explicit TimerWheel(callback_type expire, std::uint64_t now = 0)
+          : expire_(expire),
+            now_(now) {};
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        /**
+         * @brief cancels all armed timers
+         */
+        ~TimerWheel()
+        {
+            for(auto& level : slots_) {
+                for(auto& slot : level) {
+                    while(slot != nullptr) {
+                        slot->cancel();
+                    }
+                }
+            }
+        };
+
+        /**
+         * @brief arms a timer, re-arming it if it is already armed, O(1)
+         * @param timer timer to arm
+         * @param delay number of ticks until the timer expires, at least one
+         */
+        void arm(Timer& timer, std::uint64_t delay)
+        {
+            timer.cancel();
+            timer.deadline_ = now_ + (delay > 0 ? delay : 1);
+            timer.wheel_ = this;
+            insert(timer);
+            ++size_;
+        }
+
+        /**
+         * @brief advances the wheel and fires all timers expiring until then
+         * @param now new current tick, earlier ticks are ignored
+         * @return number of fired timers
+         *
+         * Timers can be armed and cancelled from the callbacks. A timer armed from a callback
+         * expires at the earliest in the next tick.
+         */
+        std::size_t advance(std::uint64_t now)
+        {
+            std::size_t fired = 0;
+            while(now_ < now) {
+                if(size_ == 0) {
+                    now_ = now;
+                    break;
+                }
+                const std::uint64_t tick = next_tick();
+                if(tick > now) {
+                    now_ = now;
+                    break;
+                }
+                now_ = tick;
+                if((tick & slot_mask) == 0) {
+                    cascade(tick);
+                }
+                fired += fire(0, tick & slot_mask);
+            }
+            return fired;
+        }
+
+        /**
+         * @brief current tick
+         */
+        inline std::uint64_t now() const
+        {
+            return now_;
+        }
+
+        /**
+         * @brief number of armed timers
+         */
+        inline std::size_t size() const
+        {
+            return size_;
+        }
+
+      private:
+
+        static constexpr unsigned int slot_bits = 6;
+        static constexpr std::uint64_t slot_mask = (1U << slot_bits) - 1;
+        static constexpr std::size_t levels = 8;
+
+        /**
+         * \internal
+         * @brief links a timer into the slot matching its deadline
+         *
+         * The level is given by the highest bit in which deadline and current tick differ, so a
+         * timer in a coarse level is moved down once the current tick reaches its slot there.
+         */
+        void insert(Timer& timer)
+        {
+            const std::uint64_t difference = timer.deadline_ ^ now_;
+            std::size_t level =
+                difference == 0 ? 0 : std::size_t {_highest_bit(difference) / slot_bits};
+            std::uint64_t slot = 0;
+            if(level >= levels) {
+                // beyond the current rotation of the coarsest level, parked in its first slot,
+                // which is reached at the start of the next rotation and is otherwise empty
+                level = levels - 1;
+                slot = 0;
+            } else {
+                slot = (timer.deadline_ >> (level * slot_bits)) & slot_mask;
+            }
+            Timer*& head = slots_[level][slot];
+            timer.next_ = head;
+            if(head != nullptr) {
+                head->link_ = &timer.next_;
+            }
+            head = &timer;
+            timer.link_ = &head;
+            masks_[level] |= std::uint64_t {1} << slot;
+        }
+
+        /**
+         * \internal
+         * @brief unlinks an armed timer
+         */
+        void remove(Timer& timer)
+        {
+            *timer.link_ = timer.next_;
+            if(timer.next_ != nullptr) {
+                timer.next_->link_ = timer.link_;
+            }
+            timer.link_ = nullptr;
+            timer.next_ = nullptr;
+            --size_;
+        }
+
+        /**
+         * \internal
+         * @brief next tick with something to do, after the current one
+         *
+         * A slot of a level is reached once the tick has the slot as digit of the level and all
+         * finer digits are zero, so the masks of the non-empty slots give the next tick of every
+         * level without stepping through the idle rotations in between.
+         */
+        std::uint64_t next_tick() const
+        {
+            // a timer later in the current rotation of the finest level always comes first
+            const std::uint64_t slot_0 = now_ & slot_mask;
+            const std::uint64_t finest = masks_[0] & ~((std::uint64_t {2} << slot_0) - 1);
+            if(finest != 0) {
+                return (now_ & ~slot_mask) + _lowest_bit(finest);
+            }
+            std::uint64_t next = ~std::uint64_t {0};
+            for(std::size_t level = 0; level < levels; ++level) {
+                if(masks_[level] == 0) {
+                    continue;
+                }
+                const auto shift = static_cast<unsigned int>(level * slot_bits);
+                const std::uint64_t rotation = std::uint64_t {1} << (shift + slot_bits);
+                const std::uint64_t digit = (now_ >> shift) & slot_mask;
+                const std::uint64_t later = masks_[level] & ~((std::uint64_t {2} << digit) - 1);
+                // slots up to the current digit are only reached again in the next rotation
+                const std::uint64_t start = (now_ & ~(rotation - 1)) + (later != 0 ? 0 : rotation);
+                const std::uint64_t slot = _lowest_bit(later != 0 ? later : masks_[level]);
+                const std::uint64_t tick = start + (slot << shift);
+                if(tick < next) {
+                    next = tick;
+                }
+            }
+            return next;
+        }
+
+        /**
+         * \internal
+         * @brief moves the timers of the coarser levels reached by a tick down
+         */
+        void cascade(std::uint64_t tick)
+        {
+            // coarsest level first, so its timers can still move into the finer slots reached now
+            std::size_t top = 1;
+            while(top + 1 < levels && ((tick >> (top * slot_bits)) & slot_mask) == 0) {
+                ++top;
+            }
+            for(std::size_t level = top; level > 0; --level) {
+                const std::uint64_t slot = (tick >> (level * slot_bits)) & slot_mask;
+                Timer* timer = std::exchange(slots_[level][slot], nullptr);
+                masks_[level] &= ~(std::uint64_t {1} << slot);
+                while(timer != nullptr) {
+                    Timer* const next = timer->next_;
+                    insert(*timer);
+                    timer = next;
+                }
+            }
+        }
+
+        /**
+         * \internal
+         * @brief fires all timers of a slot
+         */
+        std::size_t fire(std::size_t level, std::uint64_t slot)
+        {
+            // detached first, so callbacks can arm timers again without touching the batch
+            Timer* timer = std::exchange(slots_[level][slot], nullptr);
+            masks_[level] &= ~(std::uint64_t {1} << slot);
+            if(timer != nullptr) {
+                timer->link_ = &timer;
+            }
+            std::size_t fired = 0;
+            while(timer != nullptr) {
+                Timer& expired = *timer;
+                remove(expired);
+                expire_(expired);
+                ++fired;
+            }
+            return fired;
+        }
+
+        std::array<std::array<Timer*, slot_mask + 1>, levels> slots_ {};
+        std::array<std::uint64_t, levels> masks_ {};
+        callback_type expire_;
+        std::uint64_t now_;
+        std::size_t size_ {0};
+    };
+
+    inline void Timer::cancel()
+    {
+        if(link_ != nullptr) {
+            // the bit of the slot in the mask is cleared lazily, once the wheel reaches it
+            wheel_->remove(*this);
+        }
+    }
+
+    /**
+     * @brief event received by a `Timed` FSM when its timer expires
+     */
+    class Timeout : public Event {};
+
+    /**
+     * @brief mix-in giving a FSM a timer that delivers `Timeout` events
+     * @tparam T_FSM_Child class of the actual FSM implementation
+     *
+     * The FSM implementation derives from its FSM base class and from `Timed`, its wheel is
+     * constructed with `Timed::expire`. The timer adds four words to the FSM. A FSM with a timer
+     * can not be copied, moving it moves an armed timeout along.
+     */
+    template<class T_FSM_Child>
+    class Timed : private Timer {
+
+      public:
+
+        /**
+         * @brief arms the timeout, re-arming it if it is already armed
+         * @param delay number of ticks until the `Timeout` event, at least one
+         */
+        inline void arm_timeout(std::uint64_t delay)
+        {
+            Timer::wheel()->arm(*this, delay);
+        }
+
+        /**
+         * @brief cancels the timeout if it is armed
+         */
+        inline void cancel_timeout()
+        {
+            Timer::cancel();
+        }
+
+        /**
+         * @brief checks if the timeout is armed
+         */
+        inline bool timeout_armed() const
+        {
+            return Timer::armed();
+        }
+
+        /**
+         * @brief wheel the timeout is armed on
+         */
+        inline TimerWheel& timer_wheel() const
+        {
+            return *Timer::wheel();
+        }
+
+        /**
+         * @brief callback of the wheel delivering the `Timeout` event
+         */
+        static void expire(Timer& timer)
+        {
+            static_cast<T_FSM_Child&>(static_cast<Timed&>(timer)).react(Timeout {});
+        }
+
+      protected:
+
+        /**
+         * @brief mix-in constructor
+         * @param wheel wheel the timeout is armed on, constructed with `expire`
+         */
+        Timed(TimerWheel& wheel)
+          : Timer(wheel) {};
+    };
+
+    /**
+     * \internal
+     * @brief deduces the FSM of a state class
+     */
+    template<class T_FSM>
+    T_FSM* _state_fsm(const State<T_FSM>* state);
+
+    /**
+     * @brief state arming the timeout of a `Timed` FSM on entry and cancelling it on exit
+     * @tparam T_State_Base base class of the state, e.g. the generic state
+     * @tparam N_Ticks number of ticks until the `Timeout` event
+     *
+     * States that override `entry` or `exit` have to call the functions of this class as well.
+     */
+    template<class T_State_Base, std::uint64_t N_Ticks>
+    class TimeoutState : public T_State_Base {
+
+        using fsm_type =
+            std::remove_pointer_t<decltype(_state_fsm(std::declval<T_State_Base*>()))>;
+
+      public:
+
+        /**
+         * @brief number of ticks until the `Timeout` event
+         */
+        static constexpr std::uint64_t timeout = N_Ticks;
+
+        void entry(fsm_type* const fsm) const override
+        {
+            fsm->arm_timeout(N_Ticks);
+        };
+
+        void exit(fsm_type* const fsm) const override
+        {
+            fsm->cancel_timeout();
+        };
+    };
+
+}  // namespace scriptsizefsm
@@ -0,0 +1,136 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the compact storage of scriptsizefsm::CompactFSM
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {
+  public:
+
+    OnEvent(double _current)
+      : current(_current) {};
+    double current;
+};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState>;
+    friend OnState;
+    friend OffState;
+
+  public:
+
+    inline float getCurrent()
+    {
+        return current_;
+    };
+
+  protected:
+
+    inline void setCurrent(double current)
+    {
+        current_ = static_cast<float>(current);
+    };
+    FSM(float current)
+      : current_(current) {};
+    void resetter()
+    {
+        setCurrent(0.5);
+    };
+
+  private:
+
+    float current_;
+};
+
+void OnState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->setCurrent(event.current);
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::entry(FSM* const fsm) const
+{
+    fsm->setCurrent(0.);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->setCurrent(event.current);
+    transit<OnState>(fsm);
+};
+
+// the bookkeeping of the FSM is a single byte
+static_assert(sizeof(scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState>) == 1);
+static_assert(sizeof(FSM) == 2 * sizeof(float));
+static_assert(FSM::init_state == 0);
+
+int main()
+{
+    constexpr float init_current {10.F};
+    constexpr float some_current {20.F};
+
+    // Init -> OnState + init_current
+    auto fsm = scriptsizefsm::start<FSM, OnState>(init_current);
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == init_current);
+
+    // OnState + OffEvent -> OffState + zero
+    fsm.react(OffEvent());
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.getCurrent() == 0.F);
+
+    // OffState + OnEvent -> OnState + some_current
+    fsm.react(OnEvent(some_current));
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == some_current);
+
+    // OnState + OffEvent + reset -> OnState + resetter current
+    fsm.react(OffEvent());
+    fsm.reset();
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == 0.5F);
+
+    return 0;
+}
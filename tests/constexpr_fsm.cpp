@@ -0,0 +1,164 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the compile-time evaluation of scriptsizefsm::ConstexprFSM
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {
+  public:
+
+    constexpr OnEvent(double _current = 1.)
+      : current(_current) {};
+    double current;
+};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::ConstexprState<FSM> {
+  public:
+
+    constexpr void react(FSM* const fsm, const OnEvent& event) const {};
+    constexpr void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OffState : public GenericState {
+  public:
+
+    constexpr void entry(FSM* const fsm) const;
+    constexpr void react(FSM* const fsm, const OnEvent& event) const;
+};
+
+class OnState : public GenericState {
+  public:
+
+    constexpr void react(FSM* const fsm, const OnEvent& event) const;
+    constexpr void react(FSM* const fsm, const OffEvent& event) const;
+};
+
+// not reachable from the initial state
+class BrokenState : public GenericState {};
+
+using States = scriptsizefsm::StateList<OffState, OnState, BrokenState>;
+using Events = scriptsizefsm::EventList<OnEvent, OffEvent>;
+
+class FSM : public scriptsizefsm::ConstexprFSM<FSM, GenericState, States, OffState> {
+    friend scriptsizefsm::ConstexprFSM<FSM, GenericState, States, OffState>;
+    friend OffState;
+    friend OnState;
+
+  public:
+
+    constexpr double getCurrent() const
+    {
+        return current_;
+    };
+
+  protected:
+
+    constexpr FSM(double current = 0.)
+      : current_(current) {};
+
+    constexpr void setCurrent(double current)
+    {
+        current_ = current;
+    };
+
+    constexpr void resetter()
+    {
+        setCurrent(-1.);
+    };
+
+  private:
+
+    double current_;
+};
+
+constexpr void OffState::entry(FSM* const fsm) const
+{
+    fsm->setCurrent(0.);
+};
+
+constexpr void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->setCurrent(event.current);
+    transit<OnState>(fsm);
+};
+
+constexpr void OnState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->setCurrent(event.current);
+};
+
+constexpr void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+/**
+ * @brief replays a sequence of events at compile time
+ */
+constexpr bool replay()
+{
+    auto fsm = scriptsizefsm::start<FSM, OffState>();
+    fsm.react(OffEvent());
+    bool ok = fsm.is_in_state<OffState>();
+    fsm.react(OnEvent(2.));
+    ok = ok && fsm.is_in_state<OnState>() && fsm.getCurrent() == 2.;
+    fsm.react(OnEvent(3.));
+    ok = ok && fsm.is_in_state<OnState>() && fsm.getCurrent() == 3.;
+    fsm.react(OffEvent());
+    ok = ok && fsm.is_in_state<OffState>() && fsm.getCurrent() == 0.;
+    fsm.react(OnEvent());
+    fsm.reset();
+    return ok && fsm.is_in_state<OffState>() && fsm.getCurrent() == 0.;
+}
+
+static_assert(replay());
+
+constexpr auto next_state = FSM::next_state_table<Events>();
+static_assert(next_state[0][0] == 1 && next_state[0][1] == 0);
+static_assert(next_state[1][0] == 1 && next_state[1][1] == 0);
+static_assert(next_state[2][0] == 2 && next_state[2][1] == 2);
+
+constexpr auto reachable = FSM::reachable_states<Events>();
+static_assert(reachable[0] && reachable[1] && !reachable[2]);
+
+// constant initialized, so there is no initialization at startup
+SCRIPTSIZEFSM_CONSTINIT FSM global_fsm = FSM::start(5.);
+
+int main()
+{
+    // the same FSM at run time
+    assert(global_fsm.is_in_state<OffState>());
+    assert(global_fsm.getCurrent() == 5.);
+    global_fsm.react(OnEvent(7.));
+    assert(global_fsm.is_in_state<OnState>());
+    assert(global_fsm.getCurrent() == 7.);
+    global_fsm.react(OffEvent());
+    assert(global_fsm.is_in_state<OffState>());
+    assert(global_fsm.getCurrent() == 0.);
+    global_fsm.react(OnEvent());
+    global_fsm.reset();
+    assert(global_fsm.is_in_state<OffState>());
+    assert(global_fsm.getCurrent() == 0.);
+
+    // the table predicts the next state
+    assert(next_state[global_fsm.state_id()][0] == 1);
+    global_fsm.react(OnEvent());
+    assert(global_fsm.state_id() == 1);
+
+    return 0;
+}
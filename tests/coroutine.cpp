@@ -0,0 +1,174 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the coroutine front end scriptsizefsm::CoroutineFSM, requires C++20
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+
+#include "scriptsizefsm/coroutine.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class ConnectEvent : public scriptsizefsm::Event {};
+
+class AckEvent : public scriptsizefsm::Event {
+  public:
+
+    AckEvent(int _session)
+      : session(_session) {};
+    int session;
+};
+
+class TimeoutEvent : public scriptsizefsm::Event {};
+
+class DisconnectEvent : public scriptsizefsm::Event {};
+
+class IdleState {};
+class ConnectingState {};
+class ConnectedState {};
+
+using States = scriptsizefsm::StateList<IdleState, ConnectingState, ConnectedState>;
+
+class FSM : public scriptsizefsm::CoroutineFSM<FSM, States, IdleState> {
+    friend scriptsizefsm::CoroutineFSM<FSM, States, IdleState>;
+
+  public:
+
+    int session {0};
+    int timeouts {0};
+    bool auto_ack {false};
+
+  protected:
+
+    FSM(scriptsizefsm::FramePool* const pool)
+      : scriptsizefsm::CoroutineFSM<FSM, States, IdleState>(pool) {};
+
+    scriptsizefsm::Coroutine protocol()
+    {
+        while(true) {
+            set_state<IdleState>();
+            co_await next<ConnectEvent>();
+
+            set_state<ConnectingState>();
+            if(auto_ack) {
+                // raised while running, dispatched once the protocol awaits the reply
+                react(AckEvent(42));
+            }
+            const auto reply = co_await next<AckEvent, TimeoutEvent>();
+            if(reply.is<TimeoutEvent>()) {
+                ++timeouts;
+                continue;
+            }
+
+            set_state<ConnectedState>();
+            session = reply.get<AckEvent>().session;
+            co_await next<DisconnectEvent>();
+            session = 0;
+        }
+    };
+
+    void resetter()
+    {
+        timeouts = 0;
+        session = 0;
+        auto_ack = false;
+    };
+};
+
+class CountEvent : public scriptsizefsm::Event {};
+
+class CountedState {};
+
+using CounterStates = scriptsizefsm::StateList<CountedState>;
+
+class Counter : public scriptsizefsm::CoroutineFSM<Counter, CounterStates, CountedState> {
+    friend scriptsizefsm::CoroutineFSM<Counter, CounterStates, CountedState>;
+
+  public:
+
+    int counted {0};
+
+  protected:
+
+    scriptsizefsm::Coroutine protocol()
+    {
+        for(int count = 0; count < 3; ++count) {
+            co_await next<CountEvent>();
+            ++counted;
+        }
+    };
+};
+
+int main()
+{
+    scriptsizefsm::FramePool pool {};
+    auto fsm = scriptsizefsm::start<FSM, IdleState>(&pool);
+    assert(fsm.is_in_state<IdleState>());
+    assert(fsm.frame_pool() == &pool);
+
+    // Idle + Connect -> Connecting, the first event starts the protocol
+    fsm.react(ConnectEvent());
+    assert(fsm.is_in_state<ConnectingState>());
+    assert(pool.in_use() == 1);
+
+    // events that are not awaited are ignored
+    fsm.react(DisconnectEvent());
+    assert(fsm.is_in_state<ConnectingState>());
+
+    // Connecting + Timeout -> Idle
+    fsm.react(TimeoutEvent());
+    assert(fsm.is_in_state<IdleState>());
+    assert(fsm.timeouts == 1);
+
+    // Idle + Connect, Connecting + Ack -> Connected with the session of the event
+    fsm.react(ConnectEvent());
+    fsm.react(AckEvent(7));
+    assert(fsm.is_in_state<ConnectedState>());
+    assert(fsm.session == 7);
+    assert(fsm.state_id() == 2);
+
+    // Connected + Disconnect -> Idle
+    fsm.react(DisconnectEvent());
+    assert(fsm.is_in_state<IdleState>());
+    assert(fsm.session == 0);
+
+    // events raised by the protocol are queued until it suspended
+    fsm.auto_ack = true;
+    fsm.react(ConnectEvent());
+    assert(fsm.is_in_state<ConnectedState>());
+    assert(fsm.session == 42);
+
+    // reset destroys the coroutine, the frame goes back to the pool
+    fsm.reset();
+    assert(fsm.is_in_state<IdleState>());
+    assert(fsm.session == 0);
+    assert(pool.in_use() == 0);
+    fsm.react(ConnectEvent());
+    assert(fsm.is_in_state<ConnectingState>());
+    assert(pool.in_use() == 1);
+
+    // many FSMs share the pool
+    {
+        auto other = scriptsizefsm::start<FSM, IdleState>(&pool);
+        other.react(ConnectEvent());
+        assert(pool.in_use() == 2);
+    }
+    assert(pool.in_use() == 1);
+
+    // a protocol without pool that runs to its end ignores further events
+    auto counter = scriptsizefsm::start<Counter, CountedState>();
+    assert(counter.frame_pool() == nullptr);
+    for(int count = 0; count < 5; ++count) {
+        counter.react(CountEvent());
+    }
+    assert(counter.done());
+    assert(counter.counted == 3);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the counters of scriptsizefsm::CountingTracer
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/counters.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class UncountedEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+    virtual void react(FSM* const fsm, const UncountedEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override {};
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+using Events = scriptsizefsm::EventList<OnEvent, OffEvent>;
+using Tracer = scriptsizefsm::CountingTracer<States, Events>;
+using Matrix = scriptsizefsm::CounterMatrix<States, Events>;
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer>;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    transit<OnState>(fsm);
+};
+
+int main()
+{
+    auto matrix = std::make_unique<Matrix>();
+    auto fsm = scriptsizefsm::start<FSM, OnState>();
+    fsm.tracer().attach(*matrix);
+
+    // On + On is handled without transition, On + Off transits
+    fsm.react(OnEvent());
+    fsm.react(OffEvent());
+    auto counts = matrix->get<OnState, OnEvent>();
+    assert(counts.reactions == 1 && counts.handled() == 1 && counts.transitions == 0);
+    counts = matrix->get<OnState, OffEvent>();
+    assert(counts.reactions == 1 && counts.handled() == 1 && counts.transitions == 1);
+
+    // Off + Off falls through to the generic state, events not in the list share a column
+    fsm.react(OffEvent());
+    fsm.react(UncountedEvent());
+    counts = matrix->get<OffState, OffEvent>();
+    assert(counts.reactions == 1 && counts.fell_through == 1 && counts.handled() == 0);
+    counts = matrix->counts(1, Matrix::other_events);
+    assert(counts.reactions == 1 && counts.fell_through == 1);
+    assert(matrix->shards() == 1);
+
+    // every thread counts into its own shard, reading sums them up
+    std::vector<std::thread> threads {};
+    for(int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&matrix]() {
+            std::vector<FSM> workers(10, scriptsizefsm::start<FSM, OnState>());
+            for(auto& worker : workers) {
+                worker.tracer().attach(*matrix);
+            }
+            for(int toggle = 0; toggle < 1000; ++toggle) {
+                for(auto& worker : workers) {
+                    worker.react(OffEvent());
+                    worker.react(OnEvent());
+                }
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    assert(matrix->shards() == 5);
+    assert((matrix->get<OnState, OffEvent>().transitions == 1 + 40000));
+    assert((matrix->get<OffState, OnEvent>().transitions == 40000));
+
+    // a new matrix does not see the shards of an old one
+    matrix = std::make_unique<Matrix>();
+    fsm.tracer().attach(*matrix);
+    fsm.react(OnEvent());
+    assert(matrix->shards() == 1);
+    assert((matrix->get<OffState, OnEvent>().transitions == 1));
+    assert((matrix->get<OnState, OffEvent>().transitions == 0));
+
+    // a thread alternating between matrices keeps one shard in each of them
+    std::vector<std::unique_ptr<Matrix>> matrices {};
+    for(int index = 0; index < 3; ++index) {
+        matrices.emplace_back(new Matrix());
+    }
+    for(int toggle = 0; toggle < 100; ++toggle) {
+        for(auto& alternating : matrices) {
+            fsm.tracer().attach(*alternating);
+            fsm.react(OffEvent());
+            fsm.react(OnEvent());
+        }
+    }
+    for(const auto& alternating : matrices) {
+        assert(alternating->shards() == 1);
+        assert((alternating->get<OnState, OffEvent>().transitions == 100));
+    }
+
+    return 0;
+}
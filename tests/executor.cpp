@@ -0,0 +1,167 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for running mailbox-driven FSMs as actors with scriptsizefsm::Executor
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/executor.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class CountEvent : public scriptsizefsm::Event {};
+
+class ForwardEvent : public scriptsizefsm::Event {
+  public:
+
+    ForwardEvent(int _hops)
+      : hops(_hops) {};
+    int hops;
+};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const CountEvent& event) const;
+    virtual void react(FSM* const fsm, const ForwardEvent& event) const;
+};
+
+class RunningState : public GenericState {};
+
+class FSM
+  : public scriptsizefsm::FSM<FSM, GenericState>,
+    public scriptsizefsm::Mailbox<FSM, 1024> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+
+  public:
+
+    std::size_t id;
+    int counted {0};
+    int forwarded {0};
+
+    // set while reacting, to detect concurrent reactions of the same FSM
+    std::atomic<bool> reacting {false};
+
+  protected:
+
+    FSM(const GenericState* const init_state, std::size_t _id)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state),
+        id(_id) {};
+};
+
+scriptsizefsm::Executor<FSM>* executor {nullptr};
+
+std::mutex order_mutex {};
+std::vector<std::size_t> order {};
+
+void GenericState::react(FSM* const fsm, const CountEvent& event) const
+{
+    assert(!fsm->reacting.exchange(true));
+    ++fsm->counted;
+    {
+        const std::lock_guard<std::mutex> lock {order_mutex};
+        order.push_back(fsm->id);
+    }
+    fsm->reacting = false;
+};
+
+void GenericState::react(FSM* const fsm, const ForwardEvent& event) const
+{
+    assert(!fsm->reacting.exchange(true));
+    ++fsm->forwarded;
+    if(event.hops > 1) {
+        // actors post to other actors from the pool
+        const std::size_t next = (fsm->id + 1) % executor->size();
+        while(!executor->post(next, ForwardEvent(event.hops - 1))) {
+            std::this_thread::yield();
+        }
+    }
+    fsm->reacting = false;
+};
+
+int main()
+{
+    constexpr std::size_t n_fsms {200};
+    constexpr int n_producers {4};
+    constexpr int n_events {100};
+
+    scriptsizefsm::ThreadPool pool {4};
+    scriptsizefsm::Executor<FSM> actors {pool, 8};
+    executor = &actors;
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        assert(actors.spawn<RunningState>(id) == id);
+    }
+    assert(actors.size() == n_fsms);
+    assert(actors.batch_size() == 8);
+
+    // many producers post to all FSMs, every event is processed exactly once
+    std::vector<std::thread> producers {};
+    for(int producer = 0; producer < n_producers; ++producer) {
+        producers.emplace_back([&actors]() {
+            for(int event = 0; event < n_events; ++event) {
+                for(std::size_t id = 0; id < n_fsms; ++id) {
+                    while(!actors.post(id, CountEvent())) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+    }
+    for(auto& producer : producers) {
+        producer.join();
+    }
+    actors.wait();
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        assert(actors[id].counted == n_producers * n_events);
+        assert(actors[id].empty());
+    }
+
+    // events forwarded around the ring of FSMs
+    assert(actors.post(0, ForwardEvent(1000)));
+    actors.wait();
+    int forwarded = 0;
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        forwarded += actors[id].forwarded;
+    }
+    assert(forwarded == 1000);
+
+    // a FSM with a deep queue does not starve the others
+    {
+        scriptsizefsm::ThreadPool single {1};
+        scriptsizefsm::Executor<FSM> fair {single, 4};
+        fair.spawn<RunningState>(std::size_t {0});
+        fair.spawn<RunningState>(std::size_t {1});
+        order.clear();
+        std::atomic<bool> blocked {true};
+        single.submit([&blocked]() {
+            while(blocked) {
+                std::this_thread::yield();
+            }
+        });
+        for(int event = 0; event < 100; ++event) {
+            assert(fair.post(0, CountEvent()));
+        }
+        assert(fair.post(1, CountEvent()));
+        blocked = false;
+        fair.wait();
+        assert(order.size() == 101);
+        assert(order.back() == 0);
+        assert(fair[0].counted == 100);
+        assert(fair[1].counted == 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the structure-of-arrays container scriptsizefsm::Fleet
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "scriptsizefsm/fleet.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {
+  public:
+
+    OnEvent(double _current)
+      : current(_current) {};
+    double current;
+};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class BlinkEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+    virtual void react(FSM* const fsm, const BlinkEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+    void react(FSM* const fsm, const OffEvent& event) const override;
+    void react(FSM* const fsm, const BlinkEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+
+class FSM : public scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, double, int> {
+    friend scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, double, int>;
+
+  public:
+
+    inline double& current()
+    {
+        return column<double>();
+    };
+    inline int& switched_on()
+    {
+        return column<int>();
+    };
+
+  protected:
+
+    void resetter()
+    {
+        switched_on() = 0;
+    };
+};
+
+void OnState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->current() = event.current;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OnState::react(FSM* const fsm, const BlinkEvent& event) const
+{
+    fsm->react(OffEvent());
+    fsm->current() = -1.;
+};
+
+void OffState::entry(FSM* const fsm) const
+{
+    fsm->current() = 0.;
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    fsm->current() = event.current;
+    ++fsm->switched_on();
+    transit<OnState>(fsm);
+};
+
+int main()
+{
+    scriptsizefsm::Fleet<FSM> fleet {};
+    fleet.reserve(1000);
+    for(std::size_t id = 0; id < 1000; ++id) {
+        assert(fleet.add<OffState>(static_cast<double>(id), 0) == id);
+    }
+    assert(fleet.size() == 1000);
+    assert(fleet.count<OffState>() == 1000);
+    assert(fleet.column<double>()[42] == 42.);
+
+    // Off + OnEvent -> On for all
+    fleet.broadcast(OnEvent(10.));
+    assert(fleet.count<OnState>() == 1000);
+    for(std::size_t id = 0; id < fleet.size(); ++id) {
+        assert(fleet.is_in_state<OnState>(id));
+        assert(fleet.column<double>()[id] == 10.);
+        assert(fleet.column<int>()[id] == 1);
+    }
+
+    // switch off every third FSM
+    std::vector<std::size_t> ids {};
+    std::vector<OffEvent> events {};
+    for(std::size_t id = 0; id < fleet.size(); id += 3) {
+        ids.push_back(id);
+        events.emplace_back();
+    }
+    fleet.dispatch(ids, events);
+    assert(fleet.count<OffState>() == ids.size());
+    assert(fleet.is_in_state<OffState>(3));
+    assert(fleet.is_in_state<OnState>(4));
+    assert(fleet.column<double>()[3] == 0.);
+    assert(fleet.column<double>()[4] == 10.);
+
+    // handles offer the usual API
+    auto fsm = fleet[4];
+    assert(fsm.id() == 4);
+    assert(fsm.is_in_state<OnState>());
+    fsm.react(OnEvent(20.));
+    assert(fsm.current() == 20.);
+    fsm.react(OffEvent());
+    assert(fleet.is_in_state<OffState>(4));
+
+    // Off + OnEvent -> On, counts second switch on
+    fleet.react(4, OnEvent(30.));
+    assert(fleet.column<int>()[4] == 2);
+    fleet.reset(4);
+    assert(fleet.is_in_state<OffState>(4));
+    assert(fleet.column<int>()[4] == 0);
+    assert(fleet.column<double>()[4] == 0.);
+
+    // events raised during a broadcast are queued until the reaction of their FSM completed
+    fleet.broadcast(BlinkEvent());
+    assert(fleet.count<OffState>() == 1000);
+    assert(fleet.column<double>()[5] == 0.);
+
+    return 0;
+}
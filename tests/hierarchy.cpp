@@ -0,0 +1,296 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for hierarchical states, with both transit modes
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+using scriptsizefsm::TransitMode;
+
+class StartEvent : public scriptsizefsm::Event {};
+class StopEvent : public scriptsizefsm::Event {};
+class SpeedEvent : public scriptsizefsm::Event {};
+class RestartEvent : public scriptsizefsm::Event {};
+class FailEvent : public scriptsizefsm::Event {};
+class RecoverEvent : public scriptsizefsm::Event {};
+
+template<TransitMode M>
+class FSM;
+
+template<TransitMode M>
+class GenericState : public scriptsizefsm::State<FSM<M>> {
+  public:
+
+    virtual void react(FSM<M>* const fsm, const StartEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const StopEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const SpeedEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const RestartEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const FailEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const RecoverEvent& event) const {};
+};
+
+/**
+ * @brief state logging its entry and exit with its name
+ */
+template<TransitMode M, class T_Self>
+class LoggedState : public GenericState<M> {
+  public:
+
+    void entry(FSM<M>* const fsm) const override
+    {
+        fsm->log += std::string("+") + T_Self::name + " ";
+    };
+
+    void exit(FSM<M>* const fsm) const override
+    {
+        fsm->log += std::string("-") + T_Self::name + " ";
+    };
+};
+
+/**
+ * @brief intermediate base class with a reaction, which states re-expose next to their own
+ * overloads with a using-declaration
+ */
+template<TransitMode M, class T_Self>
+class Coasting : public LoggedState<M, T_Self> {
+  public:
+
+    void react(FSM<M>* const fsm, const StopEvent& event) const override;
+};
+
+template<TransitMode M>
+class Idle;
+
+template<TransitMode M>
+class Slow;
+
+// Operational { Idle, Running { Slow, Fast } }, Error
+template<TransitMode M>
+class Operational : public LoggedState<M, Operational<M>> {
+  public:
+
+    static constexpr const char* name = "op";
+    using initial = Idle<M>;
+    void react(FSM<M>* const fsm, const FailEvent& event) const override;
+};
+
+template<TransitMode M>
+class Idle : public LoggedState<M, Idle<M>> {
+  public:
+
+    static constexpr const char* name = "idle";
+    using parent = Operational<M>;
+    void react(FSM<M>* const fsm, const StartEvent& event) const override;
+};
+
+template<TransitMode M>
+class Running : public LoggedState<M, Running<M>> {
+  public:
+
+    static constexpr const char* name = "running";
+    using parent = Operational<M>;
+    using initial = Slow<M>;
+    void react(FSM<M>* const fsm, const StopEvent& event) const override;
+    void react(FSM<M>* const fsm, const RestartEvent& event) const override;
+};
+
+template<TransitMode M>
+class Slow : public LoggedState<M, Slow<M>> {
+  public:
+
+    static constexpr const char* name = "slow";
+    using parent = Running<M>;
+    void react(FSM<M>* const fsm, const SpeedEvent& event) const override;
+};
+
+template<TransitMode M>
+class Fast : public Coasting<M, Fast<M>> {
+  public:
+
+    static constexpr const char* name = "fast";
+    using parent = Running<M>;
+    using Coasting<M, Fast<M>>::react;
+    void react(FSM<M>* const fsm, const StartEvent& event) const override;
+};
+
+template<TransitMode M>
+class Error : public LoggedState<M, Error<M>> {
+  public:
+
+    static constexpr const char* name = "error";
+    void react(FSM<M>* const fsm, const RecoverEvent& event) const override;
+};
+
+template<TransitMode M>
+using States =
+    scriptsizefsm::StateList<Operational<M>, Idle<M>, Running<M>, Slow<M>, Fast<M>, Error<M>>;
+
+template<TransitMode M>
+class FSM
+  : public scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, Operational<M>> {
+    friend scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, Operational<M>>;
+
+  public:
+
+    static constexpr TransitMode transit_mode = M;
+
+    /**
+     * @brief takes the log of entries and exits since the last call
+     */
+    std::string take_log()
+    {
+        std::string taken {};
+        taken.swap(log);
+        return taken;
+    };
+
+    std::string log {};
+};
+
+template<TransitMode M, class T_Self>
+void Coasting<M, T_Self>::react(FSM<M>* const fsm, const StopEvent& event) const
+{
+    this->template transit<Slow<M>>(fsm);
+};
+
+template<TransitMode M>
+void Operational<M>::react(FSM<M>* const fsm, const FailEvent& event) const
+{
+    this->template transit<Error<M>>(fsm);
+};
+
+template<TransitMode M>
+void Idle<M>::react(FSM<M>* const fsm, const StartEvent& event) const
+{
+    this->template transit<Running<M>>(fsm);
+};
+
+template<TransitMode M>
+void Running<M>::react(FSM<M>* const fsm, const StopEvent& event) const
+{
+    this->template transit<Idle<M>>(fsm);
+};
+
+template<TransitMode M>
+void Running<M>::react(FSM<M>* const fsm, const RestartEvent& event) const
+{
+    this->template transit<Running<M>>(fsm);
+};
+
+template<TransitMode M>
+void Slow<M>::react(FSM<M>* const fsm, const SpeedEvent& event) const
+{
+    this->template transit<Fast<M>>(fsm);
+};
+
+template<TransitMode M>
+void Fast<M>::react(FSM<M>* const fsm, const StartEvent& event) const
+{
+    this->template transit<Fast<M>>(fsm);
+};
+
+template<TransitMode M>
+void Error<M>::react(FSM<M>* const fsm, const RecoverEvent& event) const
+{
+    this->template transit<Operational<M>>(fsm);
+};
+
+// reactions declared in a state and the states left by a transition are resolved at compile time
+constexpr TransitMode dispatch = TransitMode::dispatch;
+using RecoverDomain = scriptsizefsm::_transit_domain<Error<dispatch>, Operational<dispatch>>::type;
+using StopHandled = std::bool_constant<scriptsizefsm::_state_handles<
+    GenericState<dispatch>,
+    Running<dispatch>,
+    FSM<dispatch>,
+    StopEvent>()>;
+static_assert(StopHandled::value);
+static_assert(scriptsizefsm::_state_handles<
+              GenericState<dispatch>,
+              Fast<dispatch>,
+              FSM<dispatch>,
+              StopEvent>());
+static_assert(std::is_void_v<RecoverDomain>);
+static_assert(std::is_same_v<
+              scriptsizefsm::_transit_domain<Slow<dispatch>, Fast<dispatch>>::type,
+              Running<dispatch>>);
+
+template<TransitMode M>
+void test()
+{
+    // starting in a state with children starts in its initial child
+    auto fsm = scriptsizefsm::start<FSM<M>, Operational<M>>();
+    assert(fsm.template is_in_state<Idle<M>>());
+
+    // entering a state with children enters its initial child
+    fsm.react(StartEvent());
+    assert(fsm.template is_in_state<Slow<M>>());
+    assert(fsm.take_log() == "-idle +running +slow ");
+
+    fsm.react(SpeedEvent());
+    assert(fsm.template is_in_state<Fast<M>>());
+    assert(fsm.take_log() == "-slow +fast ");
+
+    // a transition to the state itself exits and enters it again
+    fsm.react(StartEvent());
+    assert(fsm.template is_in_state<Fast<M>>());
+    assert(fsm.take_log() == "-fast +fast ");
+
+    // a transition to an ancestor exits and enters the ancestor again
+    fsm.react(RestartEvent());
+    assert(fsm.template is_in_state<Slow<M>>());
+    assert(fsm.take_log() == "-fast -running +running +slow ");
+
+    // events bubble up to the parent
+    fsm.react(StopEvent());
+    assert(fsm.template is_in_state<Idle<M>>());
+    assert(fsm.take_log() == "-slow -running +idle ");
+
+    // but not past a reaction inherited from an intermediate base class, which the state hides
+    fsm.react(StartEvent());
+    fsm.react(SpeedEvent());
+    fsm.take_log();
+    fsm.react(StopEvent());
+    assert(fsm.template is_in_state<Slow<M>>());
+    assert(fsm.take_log() == "-fast +slow ");
+
+    // and to the grandparent
+    fsm.react(FailEvent());
+    assert(fsm.template is_in_state<Error<M>>());
+    assert(fsm.take_log() == "-slow -running -op +error ");
+
+    // unhandled events end in the generic state
+    fsm.react(SpeedEvent());
+    assert(fsm.template is_in_state<Error<M>>());
+    assert(fsm.take_log().empty());
+
+    fsm.react(RecoverEvent());
+    assert(fsm.template is_in_state<Idle<M>>());
+    assert(fsm.take_log() == "-error +op +idle ");
+
+    // a reset exits and enters all ancestors, and the initial child of the initial state
+    fsm.react(StartEvent());
+    fsm.take_log();
+    fsm.reset();
+    assert(fsm.template is_in_state<Idle<M>>());
+    assert(fsm.take_log() == "-slow -running -op +op +idle ");
+}
+
+int main()
+{
+    test<TransitMode::dispatch>();
+    test<TransitMode::thunks>();
+
+    return 0;
+}
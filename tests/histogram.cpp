@@ -0,0 +1,161 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the dwell time histograms of scriptsizefsm::DwellTracer
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/histogram.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+using Tracer = scriptsizefsm::DwellTracer<States, 1>;
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer>;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    transit<OnState>(fsm);
+};
+
+int main()
+{
+    using scriptsizefsm::Histogram;
+
+    // buckets are contiguous and every value lies within its bucket
+    for(std::size_t bucket = 1; bucket < Histogram::buckets; ++bucket) {
+        assert(Histogram::lower_bound(bucket) == Histogram::upper_bound(bucket - 1) + 1);
+    }
+    assert(Histogram::upper_bound(Histogram::buckets - 1) == UINT64_MAX);
+    std::mt19937_64 generator {42};
+    for(int sample = 0; sample < 100000; ++sample) {
+        const std::uint64_t value = generator() >> (generator() % 64);
+        const std::size_t bucket = Histogram::bucket(value);
+        assert(Histogram::lower_bound(bucket) <= value && value <= Histogram::upper_bound(bucket));
+    }
+
+    // quantiles are accurate to the bucket width, merging adds up the counts
+    auto histogram = std::make_unique<Histogram>();
+    for(std::uint64_t value = 1; value <= 1000; ++value) {
+        histogram->record(value);
+    }
+    assert(histogram->count() == 1000);
+    assert(histogram->quantile(0.5) >= 500 && histogram->quantile(0.5) < 500 * 9 / 8);
+    assert(histogram->quantile(1.0) >= 1000 && histogram->quantile(1.0) < 1000 * 9 / 8);
+    auto other = std::make_unique<Histogram>();
+    other->record(1U << 20U);
+    histogram->merge(*other);
+    assert(histogram->count() == 1001);
+    assert(histogram->quantile(1.0) >= 1U << 20U);
+
+    // the tracer records the time spent in the state that is left
+    auto histograms = std::make_unique<scriptsizefsm::DwellHistograms<States>>();
+    auto fsm = scriptsizefsm::start<FSM, OnState>();
+    fsm.react(OffEvent());
+    assert(histograms->get<OnState>().count() == 0);
+    fsm.tracer().attach(*histograms);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    fsm.react(OnEvent());
+    fsm.react(OffEvent());
+    fsm.react(OnEvent());
+    fsm.reset();
+    assert(histograms->get<OffState>().count() == 2);
+    assert(histograms->get<OnState>().count() == 2);
+    const double ticks_per_ms = scriptsizefsm::timestamp_frequency() / 1000.;
+    assert(static_cast<double>(histograms->get<OffState>().quantile(1.0)) > 2 * ticks_per_ms);
+
+    // with sampling, about one in four visits is recorded, also if the states alternate in step
+    // with the sampling
+    scriptsizefsm::DwellTracer<States, 4> sampled {};
+    auto sampled_histograms = std::make_unique<scriptsizefsm::DwellHistograms<States>>();
+    sampled.attach(*sampled_histograms);
+    for(std::size_t transition = 0; transition < 1000; ++transition) {
+        sampled.on_transit(fsm, transition % 2, (transition + 1) % 2);
+    }
+    const std::uint64_t sampled_on = sampled_histograms->get<OnState>().count();
+    const std::uint64_t sampled_off = sampled_histograms->get<OffState>().count();
+    assert(sampled_on > 50 && sampled_off > 50);
+    assert(sampled_on + sampled_off > 200 && sampled_on + sampled_off < 300);
+
+    // each thread records into its own histograms, which are merged while they are running
+    std::vector<std::unique_ptr<scriptsizefsm::DwellHistograms<States>>> shards {};
+    std::vector<std::thread> threads {};
+    for(int thread = 0; thread < 4; ++thread) {
+        shards.emplace_back(new scriptsizefsm::DwellHistograms<States>());
+        threads.emplace_back([shard = shards.back().get()]() {
+            std::vector<FSM> workers(10, scriptsizefsm::start<FSM, OnState>());
+            for(auto& worker : workers) {
+                worker.tracer().attach(*shard);
+            }
+            for(int toggle = 0; toggle < 1000; ++toggle) {
+                for(auto& worker : workers) {
+                    worker.react(OffEvent());
+                    worker.react(OnEvent());
+                }
+            }
+        });
+    }
+    auto merged = std::make_unique<scriptsizefsm::DwellHistograms<States>>();
+    for(const auto& shard : shards) {
+        merged->merge(*shard);
+    }
+    assert(merged->get<OnState>().count() <= 40000);
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    merged = std::make_unique<scriptsizefsm::DwellHistograms<States>>();
+    merged->merge(*histograms);
+    for(const auto& shard : shards) {
+        merged->merge(*shard);
+    }
+    assert(merged->get<OnState>().count() == 2 + 40000);
+    assert(merged->get<OffState>().count() == 2 + 40000);
+
+    return 0;
+}
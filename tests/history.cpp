@@ -0,0 +1,249 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for shallow and deep history, with both transit modes
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <string>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+using scriptsizefsm::TransitMode;
+
+class StartEvent : public scriptsizefsm::Event {};
+class StopEvent : public scriptsizefsm::Event {};
+class SpeedEvent : public scriptsizefsm::Event {};
+class ContinueEvent : public scriptsizefsm::Event {};
+class PauseEvent : public scriptsizefsm::Event {};
+class ResumeEvent : public scriptsizefsm::Event {};
+class DeepResumeEvent : public scriptsizefsm::Event {};
+
+template<TransitMode M>
+class FSM;
+
+template<TransitMode M>
+class GenericState : public scriptsizefsm::State<FSM<M>> {
+  public:
+
+    virtual void react(FSM<M>* const fsm, const StartEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const StopEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const SpeedEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const ContinueEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const PauseEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const ResumeEvent& event) const {};
+    virtual void react(FSM<M>* const fsm, const DeepResumeEvent& event) const {};
+};
+
+/**
+ * @brief state logging its entry and exit with its name
+ */
+template<TransitMode M, class T_Self>
+class LoggedState : public GenericState<M> {
+  public:
+
+    void entry(FSM<M>* const fsm) const override
+    {
+        fsm->log += std::string("+") + T_Self::name + " ";
+    };
+
+    void exit(FSM<M>* const fsm) const override
+    {
+        fsm->log += std::string("-") + T_Self::name + " ";
+    };
+};
+
+template<TransitMode M>
+class Idle;
+
+template<TransitMode M>
+class Slow;
+
+// Operational { Idle, Running { Slow, Fast } }, Paused, both Operational and Running with history
+template<TransitMode M>
+class Operational : public LoggedState<M, Operational<M>> {
+  public:
+
+    static constexpr const char* name = "op";
+    static constexpr bool history = true;
+    using initial = Idle<M>;
+    void react(FSM<M>* const fsm, const PauseEvent& event) const override;
+};
+
+template<TransitMode M>
+class Idle : public LoggedState<M, Idle<M>> {
+  public:
+
+    static constexpr const char* name = "idle";
+    using parent = Operational<M>;
+    void react(FSM<M>* const fsm, const StartEvent& event) const override;
+    void react(FSM<M>* const fsm, const ContinueEvent& event) const override;
+};
+
+template<TransitMode M>
+class Running : public LoggedState<M, Running<M>> {
+  public:
+
+    static constexpr const char* name = "running";
+    static constexpr bool history = true;
+    using parent = Operational<M>;
+    using initial = Slow<M>;
+    void react(FSM<M>* const fsm, const StopEvent& event) const override;
+};
+
+template<TransitMode M>
+class Slow : public LoggedState<M, Slow<M>> {
+  public:
+
+    static constexpr const char* name = "slow";
+    using parent = Running<M>;
+    void react(FSM<M>* const fsm, const SpeedEvent& event) const override;
+};
+
+template<TransitMode M>
+class Fast : public LoggedState<M, Fast<M>> {
+  public:
+
+    static constexpr const char* name = "fast";
+    using parent = Running<M>;
+};
+
+template<TransitMode M>
+class Paused : public LoggedState<M, Paused<M>> {
+  public:
+
+    static constexpr const char* name = "paused";
+    void react(FSM<M>* const fsm, const ResumeEvent& event) const override;
+    void react(FSM<M>* const fsm, const DeepResumeEvent& event) const override;
+};
+
+template<TransitMode M>
+using States =
+    scriptsizefsm::StateList<Operational<M>, Idle<M>, Running<M>, Slow<M>, Fast<M>, Paused<M>>;
+
+template<TransitMode M>
+class FSM : public scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, Paused<M>> {
+    friend scriptsizefsm::CompactFSM<FSM<M>, GenericState<M>, States<M>, Paused<M>>;
+
+  public:
+
+    static constexpr TransitMode transit_mode = M;
+
+    /**
+     * @brief takes the log of entries and exits since the last call
+     */
+    std::string take_log()
+    {
+        std::string taken {};
+        taken.swap(log);
+        return taken;
+    };
+
+    std::string log {};
+};
+
+template<TransitMode M>
+void Operational<M>::react(FSM<M>* const fsm, const PauseEvent& event) const
+{
+    this->template transit<Paused<M>>(fsm);
+};
+
+template<TransitMode M>
+void Idle<M>::react(FSM<M>* const fsm, const StartEvent& event) const
+{
+    this->template transit<Running<M>>(fsm);
+};
+
+template<TransitMode M>
+void Idle<M>::react(FSM<M>* const fsm, const ContinueEvent& event) const
+{
+    this->template transit<scriptsizefsm::ShallowHistory<Running<M>>>(fsm);
+};
+
+template<TransitMode M>
+void Running<M>::react(FSM<M>* const fsm, const StopEvent& event) const
+{
+    this->template transit<Idle<M>>(fsm);
+};
+
+template<TransitMode M>
+void Slow<M>::react(FSM<M>* const fsm, const SpeedEvent& event) const
+{
+    this->template transit<Fast<M>>(fsm);
+};
+
+template<TransitMode M>
+void Paused<M>::react(FSM<M>* const fsm, const ResumeEvent& event) const
+{
+    this->template transit<scriptsizefsm::ShallowHistory<Operational<M>>>(fsm);
+};
+
+template<TransitMode M>
+void Paused<M>::react(FSM<M>* const fsm, const DeepResumeEvent& event) const
+{
+    this->template transit<scriptsizefsm::DeepHistory<Operational<M>>>(fsm);
+};
+
+// the history of both states is stored next to the current state, one index each
+static_assert(sizeof(scriptsizefsm::_state_storage<States<TransitMode::dispatch>>) == 3);
+
+template<TransitMode M>
+void test()
+{
+    auto fsm = scriptsizefsm::start<FSM<M>, Paused<M>>();
+
+    // without history, the initial children are entered
+    fsm.react(ResumeEvent());
+    assert(fsm.template is_in_state<Idle<M>>());
+    assert(fsm.take_log() == "-paused +op +idle ");
+
+    fsm.react(StartEvent());
+    fsm.react(SpeedEvent());
+    fsm.react(PauseEvent());
+    assert(fsm.take_log() == "-idle +running +slow -slow +fast -fast -running -op +paused ");
+
+    // deep history resumes the innermost state
+    fsm.react(DeepResumeEvent());
+    assert(fsm.template is_in_state<Fast<M>>());
+    assert(fsm.take_log() == "-paused +op +running +fast ");
+
+    // shallow history resumes the child and enters its initial children
+    fsm.react(PauseEvent());
+    fsm.take_log();
+    fsm.react(ResumeEvent());
+    assert(fsm.template is_in_state<Slow<M>>());
+    assert(fsm.take_log() == "-paused +op +running +slow ");
+
+    // the history of a state is recorded whenever it is exited
+    fsm.react(SpeedEvent());
+    fsm.react(StopEvent());
+    fsm.react(PauseEvent());
+    fsm.react(DeepResumeEvent());
+    assert(fsm.template is_in_state<Idle<M>>());
+    fsm.take_log();
+    fsm.react(ContinueEvent());
+    assert(fsm.template is_in_state<Fast<M>>());
+    assert(fsm.take_log() == "-idle +running +fast ");
+
+    // a reset forgets the history
+    fsm.reset();
+    fsm.take_log();
+    fsm.react(DeepResumeEvent());
+    assert(fsm.template is_in_state<Idle<M>>());
+    assert(fsm.take_log() == "-paused +op +idle ");
+}
+
+int main()
+{
+    test<TransitMode::dispatch>();
+    test<TransitMode::thunks>();
+
+    return 0;
+}
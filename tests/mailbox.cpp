@@ -0,0 +1,175 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for posting events from multiple threads with scriptsizefsm::Mailbox
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/mailbox.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+class OffEvent : public scriptsizefsm::Event {};
+
+class CountEvent : public scriptsizefsm::Event {
+  public:
+
+    CountEvent(int _producer)
+      : producer(_producer) {};
+    int producer;
+};
+
+class NameEvent : public scriptsizefsm::Event {
+  public:
+
+    NameEvent(std::shared_ptr<std::string> _name)
+      : name(std::move(_name)) {};
+    std::shared_ptr<std::string> name;
+};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+    virtual void react(FSM* const fsm, const CountEvent& event) const;
+    virtual void react(FSM* const fsm, const NameEvent& event) const;
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+class FSM
+  : public scriptsizefsm::FSM<FSM, GenericState>,
+    public scriptsizefsm::Mailbox<FSM, 64> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+
+  public:
+
+    int switched_on {0};
+    std::vector<int> counted {};
+    std::string name {};
+
+  protected:
+
+    FSM(const GenericState* const init_state)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state) {};
+};
+
+void GenericState::react(FSM* const fsm, const CountEvent& event) const
+{
+    fsm->counted.push_back(event.producer);
+};
+
+void GenericState::react(FSM* const fsm, const NameEvent& event) const
+{
+    fsm->name = *event.name;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    ++fsm->switched_on;
+    transit<OnState>(fsm);
+    // events posted during a reaction are drained in the same call
+    fsm->post(OffEvent());
+};
+
+int main()
+{
+    auto fsm = scriptsizefsm::start<FSM, OffState>();
+    assert(fsm.empty());
+
+    // posting is asynchronous
+    assert(fsm.post(OnEvent()));
+    assert(fsm.is_in_state<OffState>());
+    assert(!fsm.empty());
+    assert(fsm.drain() == 2);
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.switched_on == 1);
+
+    // a full mailbox drops events
+    for(std::size_t index = 0; index < FSM::capacity; ++index) {
+        assert(fsm.post(OffEvent()));
+    }
+    assert(!fsm.post(OffEvent()));
+    assert(fsm.drain(10) == 10);
+    assert(fsm.post(OffEvent()));
+    assert(fsm.drain() == FSM::capacity - 9);
+
+    // events with non-trivial members are destroyed after the reaction
+    auto name = std::make_shared<std::string>("fsm");
+    assert(fsm.post(NameEvent(name)));
+    assert(name.use_count() == 2);
+    fsm.drain();
+    assert(fsm.name == "fsm");
+    assert(name.use_count() == 1);
+
+    // multiple producers, single consumer
+    constexpr int n_producers {4};
+    constexpr int n_events {10000};
+    std::atomic<int> running {n_producers};
+    std::vector<std::thread> producers {};
+    for(int producer = 0; producer < n_producers; ++producer) {
+        producers.emplace_back([&fsm, &running, producer]() {
+            for(int event = 0; event < n_events; ++event) {
+                while(!fsm.post(CountEvent(producer))) {
+                    std::this_thread::yield();
+                }
+            }
+            --running;
+        });
+    }
+    while(running > 0 || !fsm.empty()) {
+        fsm.drain();
+    }
+    for(auto& producer : producers) {
+        producer.join();
+    }
+    fsm.drain();
+    assert(fsm.counted.size() == n_producers * n_events);
+    for(int producer = 0; producer < n_producers; ++producer) {
+        int count = 0;
+        for(const auto counted_producer : fsm.counted) {
+            count += counted_producer == producer ? 1 : 0;
+        }
+        assert(count == n_events);
+    }
+
+    // pending events are destroyed with the FSM
+    {
+        auto other = scriptsizefsm::start<FSM, OffState>();
+        assert(other.post(NameEvent(name)));
+        assert(name.use_count() == 2);
+    }
+    assert(name.use_count() == 1);
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the thread pool and the parallel dispatch of scriptsizefsm::parallel_broadcast
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "scriptsizefsm/parallel.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OffState, OnState>;
+
+class FSM : public scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, int> {
+    friend scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, int>;
+
+  public:
+
+    inline int& switched_on()
+    {
+        return column<int>();
+    };
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    // every third FSM is broken and stays off
+    if(fsm->id() % 3 != 0) {
+        ++fsm->switched_on();
+        transit<OnState>(fsm);
+    }
+};
+
+class CompactFSM;
+
+class CompactGenericState : public scriptsizefsm::State<CompactFSM> {
+  public:
+
+    virtual void react(CompactFSM* const fsm, const OnEvent& event) const {};
+};
+
+class CompactOffState : public CompactGenericState {
+  public:
+
+    void react(CompactFSM* const fsm, const OnEvent& event) const override;
+};
+
+class CompactOnState : public CompactGenericState {};
+
+using CompactStates = scriptsizefsm::StateList<CompactOffState, CompactOnState>;
+
+using CompactBase = scriptsizefsm::
+    CompactFSM<CompactFSM, CompactGenericState, CompactStates, CompactOffState>;
+
+class CompactFSM : public CompactBase {
+    friend CompactBase;
+};
+
+void CompactOffState::react(CompactFSM* const fsm, const OnEvent& event) const
+{
+    transit<CompactOnState>(fsm);
+};
+
+int main()
+{
+    scriptsizefsm::ThreadPool pool {4};
+    assert(pool.size() == 4);
+
+    // tasks submitted from tasks are finished before wait returns
+    std::atomic<int> counter {0};
+    for(int task = 0; task < 100; ++task) {
+        pool.submit([&pool, &counter]() {
+            ++counter;
+            pool.submit([&counter]() { ++counter; });
+        });
+    }
+    pool.wait();
+    assert(counter == 200);
+
+    scriptsizefsm::Fleet<FSM> fleet {};
+    constexpr std::size_t n_fsms {100003};
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        fleet.add(0);
+    }
+
+    // Off + OnEvent -> On for all but every third FSM
+    auto stats = scriptsizefsm::parallel_broadcast(pool, fleet, OnEvent(), 1000);
+    const std::size_t broken = (n_fsms + 2) / 3;
+    assert(stats.transitions == n_fsms - broken);
+    assert(stats.count<OnState>() == n_fsms - broken);
+    assert(stats.count<OffState>() == broken);
+    assert(fleet.count<OnState>() == n_fsms - broken);
+    for(std::size_t id = 0; id < n_fsms; ++id) {
+        assert(fleet.column<int>()[id] == (id % 3 == 0 ? 0 : 1));
+    }
+
+    // On + OnEvent -> On, no transitions
+    stats = scriptsizefsm::parallel_broadcast(pool, fleet, OnEvent());
+    assert(stats.transitions == 0);
+    assert(stats.count<OnState>() == n_fsms - broken);
+
+    // On + OffEvent -> Off
+    stats = scriptsizefsm::parallel_broadcast(pool, fleet, OffEvent(), 1);
+    assert(stats.transitions == n_fsms - broken);
+    assert(stats.count<OffState>() == n_fsms);
+
+    // a dispatch only waits for its own chunks, not for tasks that keep rescheduling themselves
+    std::atomic<bool> stop {false};
+    std::function<void()> spin = [&pool, &stop, &spin]() {
+        if(!stop) {
+            pool.submit(spin);
+        }
+    };
+    pool.submit(spin);
+    stats = scriptsizefsm::parallel_broadcast(pool, fleet, OnEvent(), 1000);
+    assert(stats.transitions == n_fsms - broken);
+    stop = true;
+    pool.wait();
+
+    // a throwing task still counts as finished
+    {
+        scriptsizefsm::ThreadPool single {1};
+        std::atomic<bool> started {false};
+        std::atomic<bool> release {false};
+        single.submit([&started, &release]() {
+            started = true;
+            while(!release) {
+                std::this_thread::yield();
+            }
+        });
+        while(!started) {
+            std::this_thread::yield();
+        }
+        // the worker is busy, so the throwing task runs in wait on this thread
+        scriptsizefsm::ThreadPool::Latch latch {};
+        single.submit([]() { throw std::runtime_error("task failed"); }, latch);
+        bool thrown = false;
+        try {
+            single.wait(latch);
+        } catch(const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown && latch.done());
+        release = true;
+        single.wait();
+    }
+
+    // independent FSMs created with start
+    std::vector<CompactFSM> fsms(5000, scriptsizefsm::start<CompactFSM, CompactOffState>());
+    const auto compact_stats = scriptsizefsm::parallel_broadcast(pool, fsms, OnEvent(), 64);
+    assert(compact_stats.transitions == fsms.size());
+    for(const auto& fsm : fsms) {
+        assert(fsm.is_in_state<CompactOnState>());
+    }
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the group-by-state dispatch scriptsizefsm::react_batch
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include "scriptsizefsm/fleet.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class TickEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const TickEvent& event) const {};
+};
+
+class RedState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const TickEvent& event) const override;
+};
+
+class GreenState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const TickEvent& event) const override;
+};
+
+class YellowState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const TickEvent& event) const override;
+    void react_batch(FSM* const* fsms, std::size_t count, const TickEvent& event) const;
+};
+
+using States = scriptsizefsm::StateList<RedState, GreenState, YellowState>;
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, RedState> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, RedState>;
+    friend RedState;
+    friend GreenState;
+    friend YellowState;
+
+  public:
+
+    int ticks {0};
+
+  protected:
+
+    FSM() = default;
+};
+
+void RedState::react(FSM* const fsm, const TickEvent& event) const
+{
+    ++fsm->ticks;
+    transit<GreenState>(fsm);
+};
+
+void GreenState::react(FSM* const fsm, const TickEvent& event) const
+{
+    ++fsm->ticks;
+    transit<YellowState>(fsm);
+};
+
+void YellowState::react(FSM* const fsm, const TickEvent& event) const
+{
+    ++fsm->ticks;
+    transit<RedState>(fsm);
+};
+
+int yellow_batches {0};
+
+void YellowState::react_batch(FSM* const* fsms, std::size_t count, const TickEvent& event) const
+{
+    ++yellow_batches;
+    for(std::size_t index = 0; index < count; ++index) {
+        ++fsms[index]->ticks;
+        transit<RedState>(fsms[index]);
+    }
+};
+
+int main()
+{
+    std::vector<FSM> fsms {};
+    for(std::size_t index = 0; index < 300; ++index) {
+        fsms.push_back(scriptsizefsm::start<FSM, RedState>());
+        // spread the FSMs over all states
+        for(std::size_t tick = 0; tick < index % 3; ++tick) {
+            fsms.back().react(TickEvent());
+        }
+    }
+
+    // every FSM reacts exactly once, even if it transits into a later bucket
+    scriptsizefsm::react_batch(fsms, TickEvent());
+    assert(yellow_batches == 1);
+    for(std::size_t index = 0; index < fsms.size(); ++index) {
+        assert(fsms[index].ticks == static_cast<int>(index % 3) + 1);
+        assert(fsms[index].state_id() == (index + 1) % 3);
+    }
+
+    // results match reacting one by one
+    auto expected = fsms;
+    for(auto& fsm : expected) {
+        fsm.react(TickEvent());
+    }
+    scriptsizefsm::react_batch(fsms.data(), fsms.size(), TickEvent());
+    for(std::size_t index = 0; index < fsms.size(); ++index) {
+        assert(fsms[index].state_id() == expected[index].state_id());
+        assert(fsms[index].ticks == expected[index].ticks);
+    }
+
+    // the buckets can be sorted in a buffer of the caller
+    expected = fsms;
+    for(auto& fsm : expected) {
+        fsm.react(TickEvent());
+    }
+    std::vector<FSM*> scratch(fsms.size());
+    scriptsizefsm::react_batch(fsms.data(), fsms.size(), TickEvent(), scratch.data());
+    for(std::size_t index = 0; index < fsms.size(); ++index) {
+        assert(fsms[index].state_id() == expected[index].state_id());
+        assert(fsms[index].ticks == expected[index].ticks);
+    }
+
+    // empty buckets are skipped
+    std::vector<FSM> red_fsms(10, scriptsizefsm::start<FSM, RedState>());
+    scriptsizefsm::react_batch(red_fsms, TickEvent());
+    assert(yellow_batches == 3);
+    for(const auto& fsm : red_fsms) {
+        assert(fsm.is_in_state<GreenState>());
+    }
+
+    return 0;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the flight recorder scriptsizefsm::FlightRecorder
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <atomic>
+#include <cassert>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "scriptsizefsm/recorder.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class UnlistedEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+    virtual void react(FSM* const fsm, const UnlistedEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+using Events = scriptsizefsm::EventList<OnEvent, OffEvent>;
+using Tracer = scriptsizefsm::FlightTracer<States, Events>;
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer>;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    transit<OnState>(fsm);
+};
+
+using Kind = scriptsizefsm::FlightRecorder::Kind;
+using Record = scriptsizefsm::FlightRecorder::Record;
+
+bool read_header(const char* path, scriptsizefsm::FlightRecorder::Header& header)
+{
+    std::FILE* const file = std::fopen(path, "rb");
+    if(file == nullptr) {
+        return false;
+    }
+    const bool read = std::fread(&header, sizeof(header), 1, file) == 1;
+    std::fclose(file);
+    return read && header.magic == scriptsizefsm::FlightRecorder::magic;
+}
+
+bool read_records(const char* path, std::vector<Record>& records)
+{
+    scriptsizefsm::FlightRecorder::Header header {};
+    std::FILE* const file = std::fopen(path, "rb");
+    if(file == nullptr) {
+        return false;
+    }
+    bool read = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                std::fseek(file, static_cast<long>(header.names_size), SEEK_CUR) == 0;
+    records.resize(header.capacity);
+    read = read &&
+           std::fread(records.data(), sizeof(Record), records.size(), file) == records.size();
+    std::fclose(file);
+    return read;
+}
+
+/**
+ * @brief record of the concurrent writers, with all fields derived from the same number
+ */
+void record_number(scriptsizefsm::FlightRecorder& recorder, std::uint32_t number)
+{
+    const auto id = static_cast<std::uint16_t>(number);
+    recorder.record(Kind::transit, number, id, id, id);
+}
+
+bool consistent(const Record& record)
+{
+    const auto id = static_cast<std::uint16_t>(record.instance);
+    return record.torn != 0 ||
+           (record.kind == Kind::transit && record.from == id && record.to == id &&
+            record.event == id);
+}
+
+/**
+ * @brief temporary dump file, removed on exit and when an assertion fails
+ *
+ * Crash dump paths have at most 255 characters.
+ */
+char dump_path[256] {};
+
+void remove_dump(int signal)
+{
+    ::unlink(dump_path);
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+struct DumpFile {
+    DumpFile()
+    {
+        const char* directory = std::getenv("TMPDIR");
+        const char* const name = "/scriptsizefsm_recorder_XXXXXX";
+        if(directory == nullptr || std::strlen(directory) + std::strlen(name) >= sizeof dump_path) {
+            directory = "/tmp";
+        }
+        std::snprintf(dump_path, sizeof(dump_path), "%s%s", directory, name);
+        const int file = ::mkstemp(dump_path);
+        assert(file >= 0);
+        ::close(file);
+        std::signal(SIGABRT, &remove_dump);
+    }
+
+    ~DumpFile()
+    {
+        ::unlink(dump_path);
+    }
+
+    const char* c_str() const
+    {
+        return dump_path;
+    }
+};
+
+int main()
+{
+    scriptsizefsm::FlightRecorder recorder {6, States {}, Events {}};
+    assert(recorder.capacity() == 8);
+
+    // reactions and transitions are recorded with the state and event indices
+    auto fsm = scriptsizefsm::start<FSM, OnState>();
+    fsm.tracer().attach(recorder, 7);
+    fsm.react(OffEvent());
+    fsm.react(UnlistedEvent());
+    fsm.reset();
+    auto records = recorder.records();
+    assert(records.size() == 4);
+    assert(records[0].kind == Kind::react && records[0].from == 0 && records[0].event == 1);
+    assert(records[1].kind == Kind::transit && records[1].from == 0 && records[1].to == 1);
+    assert(records[1].event == 1 && records[1].instance == 7);
+    assert(records[2].kind == Kind::react && records[2].from == 1);
+    assert(records[2].event == scriptsizefsm::FlightRecorder::no_event);
+    assert(records[3].kind == Kind::reset && records[3].from == 1);
+    assert(records[0].timestamp <= records[3].timestamp);
+
+    // only the most recent records are kept
+    for(int toggle = 0; toggle < 50; ++toggle) {
+        fsm.react(OffEvent());
+        fsm.react(OnEvent());
+    }
+    records = recorder.records();
+    assert(recorder.written() == 4 + 200);
+    assert(records.size() == 8);
+    assert(records.back().kind == Kind::transit && records.back().to == 0);
+
+    // dumped on demand
+    const DumpFile path {};
+    scriptsizefsm::FlightRecorder::Header header {};
+    assert(recorder.dump(path.c_str()));
+    assert(read_header(path.c_str(), header));
+    assert(header.written == 204 && header.capacity == 8 && header.n_states == 2);
+    std::remove(path.c_str());
+
+    // dumped on a fatal signal
+    const pid_t child = ::fork();
+    if(child == 0) {
+        // the crash dump of the child is checked by the parent, so it is not removed on abort
+        std::signal(SIGABRT, SIG_DFL);
+        scriptsizefsm::FlightRecorder crashing {16, States {}, Events {}};
+        if(!crashing.dump_on_fatal_signal(path.c_str())) {
+            std::_Exit(1);
+        }
+        auto doomed = scriptsizefsm::start<FSM, OnState>();
+        doomed.tracer().attach(crashing, 1);
+        doomed.react(OffEvent());
+        std::abort();
+    }
+    int status = 0;
+    assert(::waitpid(child, &status, 0) == child);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    assert(read_header(path.c_str(), header));
+    assert(header.written == 2 && header.capacity == 16);
+    std::remove(path.c_str());
+
+    // records overwritten while they are read are left out instead of being mixed
+    scriptsizefsm::FlightRecorder shared {4, States {}, Events {}};
+    for(std::uint32_t number = 0; number < shared.capacity(); ++number) {
+        record_number(shared, number);
+    }
+    std::atomic<bool> stop {false};
+    std::vector<std::thread> writers {};
+    for(std::uint32_t writer = 1; writer <= 2; ++writer) {
+        writers.emplace_back([&shared, &stop, writer]() {
+            for(std::uint32_t number = writer << 24U; !stop.load(); ++number) {
+                record_number(shared, number);
+            }
+        });
+    }
+    std::vector<Record> dumped {};
+    for(int round = 0; round < 200; ++round) {
+        for(const auto& record : shared.records()) {
+            assert(record.torn == 0 && consistent(record));
+        }
+        if(round % 20 == 0) {
+            assert(shared.dump(path.c_str()));
+            assert(read_records(path.c_str(), dumped));
+            for(const auto& record : dumped) {
+                assert(consistent(record));
+            }
+        }
+    }
+    stop.store(true);
+    for(auto& writer : writers) {
+        writer.join();
+    }
+
+    return 0;
+}
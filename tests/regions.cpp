@@ -0,0 +1,224 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for scriptsizefsm::RegionFSM
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "scriptsizefsm/regions.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class PowerEvent : public scriptsizefsm::Event {};
+class BrightEvent : public scriptsizefsm::Event {};
+class FaultEvent : public scriptsizefsm::Event {};
+class ClearEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+// power region: Off, On
+class PowerState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const PowerEvent& event) const {};
+};
+
+class OffState : public PowerState {
+  public:
+
+    void react(FSM* const fsm, const PowerEvent& event) const override;
+};
+
+class OnState : public PowerState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+    void exit(FSM* const fsm) const override;
+    void react(FSM* const fsm, const PowerEvent& event) const override;
+};
+
+// brightness region: Dim, Bright, also reacts to the power event
+class BrightnessState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const PowerEvent& event) const {};
+    virtual void react(FSM* const fsm, const BrightEvent& event) const {};
+};
+
+class DimState : public BrightnessState {
+  public:
+
+    void react(FSM* const fsm, const BrightEvent& event) const override;
+};
+
+class BrightState : public BrightnessState {
+  public:
+
+    void react(FSM* const fsm, const PowerEvent& event) const override;
+};
+
+// fault region: Ok, Warning, Failed
+class FaultState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const FaultEvent& event) const {};
+    virtual void react(FSM* const fsm, const ClearEvent& event) const;
+};
+
+class OkState : public FaultState {
+  public:
+
+    void react(FSM* const fsm, const FaultEvent& event) const override;
+};
+
+class WarningState : public FaultState {
+  public:
+
+    void react(FSM* const fsm, const FaultEvent& event) const override;
+};
+
+class FailedState : public FaultState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+};
+
+using PowerRegion =
+    scriptsizefsm::Region<PowerState, scriptsizefsm::StateList<OffState, OnState>, OffState>;
+using BrightnessRegion = scriptsizefsm::
+    Region<BrightnessState, scriptsizefsm::StateList<DimState, BrightState>, DimState>;
+using FaultRegion = scriptsizefsm::Region<
+    FaultState,
+    scriptsizefsm::StateList<OkState, WarningState, FailedState>,
+    OkState>;
+using FSMBase = scriptsizefsm::RegionFSM<FSM, PowerRegion, BrightnessRegion, FaultRegion>;
+
+class FSM : public FSMBase {
+    friend FSMBase;
+
+  public:
+
+    std::string log {};
+    int resets {0};
+
+  protected:
+
+    void resetter()
+    {
+        ++resets;
+    };
+};
+
+// the current states of all three regions fit into four bits of one byte
+static_assert(FSM::n_bits == 4);
+static_assert(std::is_same_v<FSM::word_type, std::uint8_t>);
+static_assert(sizeof(FSMBase) == 1);
+
+void OffState::react(FSM* const fsm, const PowerEvent& event) const
+{
+    transit<OnState>(fsm);
+};
+
+void OnState::entry(FSM* const fsm) const
+{
+    fsm->log += "+on ";
+};
+
+void OnState::exit(FSM* const fsm) const
+{
+    fsm->log += "-on ";
+};
+
+void OnState::react(FSM* const fsm, const PowerEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void DimState::react(FSM* const fsm, const BrightEvent& event) const
+{
+    transit<BrightState>(fsm);
+};
+
+void BrightState::react(FSM* const fsm, const PowerEvent& event) const
+{
+    transit<DimState>(fsm);
+};
+
+void FaultState::react(FSM* const fsm, const ClearEvent& event) const
+{
+    transit<OkState>(fsm);
+};
+
+void OkState::react(FSM* const fsm, const FaultEvent& event) const
+{
+    transit<WarningState>(fsm);
+};
+
+void WarningState::react(FSM* const fsm, const FaultEvent& event) const
+{
+    transit<FailedState>(fsm);
+};
+
+void FailedState::entry(FSM* const fsm) const
+{
+    fsm->log += "+failed ";
+    // events raised in a reaction are queued until the current reaction completed
+    fsm->react(PowerEvent());
+};
+
+int main()
+{
+    auto fsm = FSM::start();
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.is_in_state<DimState>());
+    assert(fsm.is_in_state<OkState>());
+
+    // the regions change independently
+    fsm.react(BrightEvent());
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.is_in_state<BrightState>());
+    assert(fsm.is_in_state<OkState>());
+
+    // a single event reaches every region that reacts to it
+    fsm.react(PowerEvent());
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.is_in_state<DimState>());
+    assert(fsm.is_in_state<OkState>());
+    assert(fsm.log == "+on ");
+
+    fsm.react(FaultEvent());
+    assert(fsm.state_id<2>() == 1);
+    assert(fsm.state_id<0>() == 1);
+    assert(fsm.state_id<1>() == 0);
+
+    fsm.react(FaultEvent());
+    assert(fsm.is_in_state<FailedState>());
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.log == "+on +failed -on ");
+
+    fsm.react(ClearEvent());
+    assert(fsm.is_in_state<OkState>());
+
+    // a reset exits and enters the states of all regions
+    fsm.react(PowerEvent());
+    fsm.react(BrightEvent());
+    fsm.react(FaultEvent());
+    fsm.log.clear();
+    fsm.reset();
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.is_in_state<DimState>());
+    assert(fsm.is_in_state<OkState>());
+    assert(fsm.log == "-on ");
+    assert(fsm.resets == 1);
+
+    return 0;
+}
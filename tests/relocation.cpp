@@ -0,0 +1,183 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for copying and moving FSMs, e.g. when stored in a std::vector
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+class FSM : public scriptsizefsm::FSM<FSM, GenericState> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+    friend OnState;
+
+  public:
+
+    int id;
+    int switched_on {0};
+
+  protected:
+
+    FSM(const GenericState* const init_state, int _id)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state),
+        id(_id) {};
+};
+
+void OnState::entry(FSM* const fsm) const
+{
+    ++fsm->switched_on;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    transit<OnState>(fsm);
+};
+
+class CompactFSM;
+
+class CompactGenericState : public scriptsizefsm::State<CompactFSM> {
+  public:
+
+    virtual void react(CompactFSM* const fsm, const OnEvent& event) const {};
+};
+
+class CompactOffState : public CompactGenericState {
+  public:
+
+    void react(CompactFSM* const fsm, const OnEvent& event) const override;
+};
+
+class CompactOnState : public CompactGenericState {};
+
+using CompactStates = scriptsizefsm::StateList<CompactOffState, CompactOnState>;
+
+using CompactBase = scriptsizefsm::
+    CompactFSM<CompactFSM, CompactGenericState, CompactStates, CompactOffState>;
+
+class CompactFSM : public CompactBase {
+    friend CompactBase;
+
+  public:
+
+    int id;
+
+  protected:
+
+    CompactFSM(int _id)
+      : id(_id) {};
+};
+
+void CompactOffState::react(CompactFSM* const fsm, const OnEvent& event) const
+{
+    transit<CompactOnState>(fsm);
+};
+
+// compact FSMs can be relocated with memcpy
+static_assert(std::is_trivially_copyable_v<CompactFSM>);
+static_assert(std::is_nothrow_move_constructible_v<FSM>);
+static_assert(std::is_nothrow_move_assignable_v<FSM>);
+
+int main()
+{
+    std::vector<FSM> fsms {};
+    for(int id = 0; id < 100; ++id) {
+        // reallocates the vector multiple times
+        fsms.push_back(scriptsizefsm::start<FSM, OffState>(id));
+        fsms.back().react(OnEvent());
+    }
+
+    // every FSM still modifies itself and not the object it was moved from
+    for(auto& fsm : fsms) {
+        assert(fsm.is_in_state<OnState>());
+        assert(fsm.switched_on == 1);
+        fsm.react(OffEvent());
+        fsm.react(OnEvent());
+        assert(fsm.switched_on == 2);
+    }
+
+    // switch off odd FSMs and move them to the front
+    for(auto& fsm : fsms) {
+        if(fsm.id % 2 == 1) {
+            fsm.react(OffEvent());
+        }
+    }
+    std::stable_partition(fsms.begin(), fsms.end(), [](const FSM& fsm) {
+        return fsm.is_in_state<OffState>();
+    });
+    for(std::size_t index = 0; index < fsms.size(); ++index) {
+        assert(fsms[index].is_in_state<OffState>() == (index < 50));
+        assert((fsms[index].id % 2 == 1) == (index < 50));
+    }
+
+    // swapped FSMs keep working
+    std::swap(fsms[0], fsms[99]);
+    fsms[0].react(OffEvent());
+    fsms[99].react(OnEvent());
+    assert(fsms[0].is_in_state<OffState>());
+    assert(fsms[0].switched_on == 2);
+    assert(fsms[99].is_in_state<OnState>());
+    assert(fsms[99].switched_on == 3);
+
+    // copies are independent
+    auto copy = fsms[99];
+    copy.react(OffEvent());
+    assert(copy.is_in_state<OffState>());
+    assert(fsms[99].is_in_state<OnState>());
+    copy.reset();
+    assert(copy.is_in_state<OffState>());
+
+    std::vector<CompactFSM> compact_fsms {};
+    for(int id = 0; id < 100; ++id) {
+        compact_fsms.push_back(scriptsizefsm::start<CompactFSM, CompactOffState>(id));
+    }
+    compact_fsms[42].react(OnEvent());
+    std::sort(compact_fsms.begin(), compact_fsms.end(), [](const CompactFSM& lhs, const CompactFSM& rhs) {
+        return lhs.is_in_state<CompactOnState>() && !rhs.is_in_state<CompactOnState>();
+    });
+    assert(compact_fsms[0].id == 42);
+    assert(compact_fsms[0].is_in_state<CompactOnState>());
+
+    return 0;
+}
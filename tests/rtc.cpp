@@ -0,0 +1,177 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the run-to-completion semantics of reactions raising events
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <string>
+#include <utility>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class StartEvent : public scriptsizefsm::Event {};
+
+class StepEvent : public scriptsizefsm::Event {
+  public:
+
+    StepEvent(std::string _name)
+      : name(std::move(_name)) {};
+    std::string name;
+};
+
+class CountEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const StartEvent& event) const {};
+    virtual void react(FSM* const fsm, const StepEvent& event) const {};
+    virtual void react(FSM* const fsm, const CountEvent& event) const {};
+};
+
+class IdleState : public GenericState {
+  public:
+
+    void exit(FSM* const fsm) const override;
+    void react(FSM* const fsm, const StartEvent& event) const override;
+};
+
+class BusyState : public GenericState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+    void react(FSM* const fsm, const StepEvent& event) const override;
+    void react(FSM* const fsm, const CountEvent& event) const override;
+};
+
+class FSM : public scriptsizefsm::FSM<FSM, GenericState> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+
+  public:
+
+    std::string log {};
+    int countdown {0};
+
+  protected:
+
+    FSM(const GenericState* const init_state)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state) {};
+};
+
+void IdleState::exit(FSM* const fsm) const
+{
+    fsm->log += "exit-idle ";
+};
+
+void IdleState::react(FSM* const fsm, const StartEvent& event) const
+{
+    fsm->log += "start ";
+    fsm->react(StepEvent("first"));
+    transit<BusyState>(fsm);
+};
+
+void BusyState::entry(FSM* const fsm) const
+{
+    fsm->log += "entry-busy ";
+    fsm->react(StepEvent("second"));
+};
+
+void BusyState::react(FSM* const fsm, const StepEvent& event) const
+{
+    fsm->log += event.name + " ";
+};
+
+void BusyState::react(FSM* const fsm, const CountEvent& event) const
+{
+    if(fsm->countdown > 0) {
+        --fsm->countdown;
+        fsm->react(CountEvent());
+    }
+};
+
+class PingEvent : public scriptsizefsm::Event {};
+
+class Ping;
+
+class GenericPingState : public scriptsizefsm::State<Ping> {
+  public:
+
+    virtual void react(Ping* const fsm, const PingEvent& event) const {};
+};
+
+class LeftState : public GenericPingState {
+  public:
+
+    void react(Ping* const fsm, const PingEvent& event) const override;
+};
+
+class RightState : public GenericPingState {
+  public:
+
+    void react(Ping* const fsm, const PingEvent& event) const override;
+};
+
+using PingStates = scriptsizefsm::StateList<LeftState, RightState>;
+
+class Ping : public scriptsizefsm::CompactFSM<Ping, GenericPingState, PingStates, LeftState> {
+    friend scriptsizefsm::CompactFSM<Ping, GenericPingState, PingStates, LeftState>;
+
+  public:
+
+    int remaining {0};
+    bool reached_right {false};
+};
+
+void LeftState::react(Ping* const fsm, const PingEvent& event) const
+{
+    if(fsm->remaining > 0) {
+        --fsm->remaining;
+        fsm->react(PingEvent());
+    }
+    transit<RightState>(fsm);
+};
+
+void RightState::react(Ping* const fsm, const PingEvent& event) const
+{
+    // the queued event is only dispatched once the transition to this state completed
+    fsm->reached_right = true;
+    if(fsm->remaining > 0) {
+        --fsm->remaining;
+        fsm->react(PingEvent());
+    }
+    transit<LeftState>(fsm);
+};
+
+int main()
+{
+    // events raised by react and entry are processed after the transition completed
+    auto fsm = scriptsizefsm::start<FSM, IdleState>();
+    fsm.react(StartEvent());
+    assert(fsm.is_in_state<BusyState>());
+    assert(fsm.log == "start exit-idle entry-busy first second ");
+
+    // chatty FSM raising an event in every reaction does not grow the stack
+    fsm.countdown = 1000000;
+    fsm.react(CountEvent());
+    assert(fsm.countdown == 0);
+
+    // same for index based FSMs, alternating the states in a flat loop
+    auto ping = scriptsizefsm::start<Ping, LeftState>();
+    ping.remaining = 1000001;
+    ping.react(PingEvent());
+    assert(ping.remaining == 0);
+    assert(ping.reached_right);
+    assert(ping.is_in_state<LeftState>());
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the vectorized transition kernel scriptsizefsm::TransitionKernel
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/simd.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+class OffEvent : public scriptsizefsm::Event {};
+class ToggleEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {};
+
+class OnState : public GenericState {
+  public:
+
+    void entry(FSM* const fsm) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void exit(FSM* const fsm) const override;
+};
+
+using States = scriptsizefsm::StateList<OffState, OnState>;
+using Events = scriptsizefsm::EventList<OnEvent, OffEvent, ToggleEvent>;
+using Table = scriptsizefsm::TransitionTable<
+    scriptsizefsm::Row<OffState, OnEvent, OnState>,
+    scriptsizefsm::Row<OffState, ToggleEvent, OnState>,
+    scriptsizefsm::Row<OnState, OffEvent, OffState>,
+    scriptsizefsm::Row<OnState, ToggleEvent, OffState>>;
+using Kernel = scriptsizefsm::TransitionKernel<States, Events, Table>;
+
+struct Counters {
+    int entries;
+    int exits;
+};
+
+class FSM : public scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, Counters> {
+    friend scriptsizefsm::FleetFSM<FSM, GenericState, States, OffState, Counters>;
+
+  public:
+
+    inline Counters& counters()
+    {
+        return column<Counters>();
+    };
+};
+
+void OnState::entry(FSM* const fsm) const
+{
+    assert(fsm->is_in_state<OnState>());
+    ++fsm->counters().entries;
+};
+
+void OffState::exit(FSM* const fsm) const
+{
+    assert(fsm->is_in_state<OffState>());
+    ++fsm->counters().exits;
+};
+
+// machine with more states than fit into a single shuffle
+constexpr std::size_t n_ring_states {40};
+
+template<std::size_t S>
+class RingState : public scriptsizefsm::State<FSM> {};
+
+class StepEvent : public scriptsizefsm::Event {};
+class BackEvent : public scriptsizefsm::Event {};
+
+template<std::size_t... I>
+auto make_ring(std::index_sequence<I...>) -> std::pair<
+    scriptsizefsm::StateList<RingState<I>...>,
+    scriptsizefsm::TransitionTable<
+        scriptsizefsm::Row<RingState<I>, StepEvent, RingState<(I + 1) % n_ring_states>>...,
+        scriptsizefsm::Row<RingState<I>, BackEvent, RingState<(I + 7) % n_ring_states>>...>>;
+
+using Ring = decltype(make_ring(std::make_index_sequence<n_ring_states> {}));
+using RingKernel = scriptsizefsm::TransitionKernel<
+    Ring::first_type,
+    scriptsizefsm::EventList<StepEvent, BackEvent>,
+    Ring::second_type>;
+
+// the lookup table is available at compile time
+static_assert(Kernel::next_state(0, 0) == 1);
+static_assert(Kernel::next_state(0, 1) == 0);
+static_assert(Kernel::next_state(1, Kernel::no_event) == 1);
+static_assert(RingKernel::next_state(39, 0) == 0);
+static_assert(RingKernel::next_state(39, 1) == 6);
+static_assert(RingKernel::stride % 16 == 0 && RingKernel::stride >= n_ring_states + 3);
+
+template<class T_Kernel>
+void check_against_scalar(std::size_t n_states, std::size_t n_events)
+{
+    std::mt19937 rng {42};
+    std::uniform_int_distribution<std::size_t> state_dist {0, n_states - 1};
+    std::uniform_int_distribution<std::size_t> event_dist {0, n_events};
+
+    // odd size to cover the scalar tail
+    constexpr std::size_t count {1003};
+    std::vector<std::uint8_t> states(count);
+    std::vector<std::uint8_t> events(count);
+    for(std::size_t lane = 0; lane < count; ++lane) {
+        states[lane] = static_cast<std::uint8_t>(state_dist(rng));
+        // event index n_events is outside of the list
+        events[lane] = static_cast<std::uint8_t>(event_dist(rng));
+    }
+    auto expected = states;
+    std::vector<std::size_t> expected_changes {};
+    T_Kernel::advance_scalar(
+        expected.data(),
+        events.data(),
+        count,
+        [&expected_changes](std::size_t lane, std::uint8_t from, std::uint8_t to) {
+            assert(from != to);
+            expected_changes.push_back(lane);
+        }
+    );
+
+    std::vector<std::size_t> changes {};
+    const auto initial = states;
+    T_Kernel::advance(
+        states.data(),
+        events.data(),
+        count,
+        [&](std::size_t lane, std::uint8_t from, std::uint8_t to) {
+            assert(initial[lane] == from);
+            assert(expected[lane] == to);
+            changes.push_back(lane);
+        }
+    );
+    assert(states == expected);
+    assert(changes == expected_changes);
+}
+
+int main()
+{
+    // built for an instruction set the processor lacks, skipped
+#if defined(__GNUC__) && defined(__AVX2__)
+    if(!__builtin_cpu_supports("avx2")) {
+        return 77;
+    }
+#elif defined(__GNUC__) && defined(__SSSE3__)
+    if(!__builtin_cpu_supports("ssse3")) {
+        return 77;
+    }
+#endif
+
+    check_against_scalar<Kernel>(States::size, Events::size);
+    check_against_scalar<RingKernel>(n_ring_states, 2);
+
+    scriptsizefsm::Fleet<FSM> fleet {};
+    for(std::size_t id = 0; id < 1000; ++id) {
+        fleet.add(Counters {0, 0});
+    }
+
+    // switch on every second FSM, all others get no event
+    std::vector<std::uint8_t> events(fleet.size(), Kernel::no_event);
+    for(std::size_t id = 0; id < fleet.size(); id += 2) {
+        events[id] = scriptsizefsm::index_of<OnEvent, Events>;
+    }
+    Kernel::advance(fleet, events.data());
+    assert(fleet.count<OnState>() == fleet.size() / 2);
+    for(std::size_t id = 0; id < fleet.size(); ++id) {
+        const int switched = id % 2 == 0 ? 1 : 0;
+        assert(fleet.column<Counters>()[id].entries == switched);
+        assert(fleet.column<Counters>()[id].exits == switched);
+    }
+
+    // OnEvent in OnState is ignored and calls no entry or exit functions
+    Kernel::advance(fleet, events.data());
+    assert(fleet.column<Counters>()[0].entries == 1);
+
+    // toggle all FSMs
+    std::fill(events.begin(), events.end(), scriptsizefsm::index_of<ToggleEvent, Events>);
+    Kernel::advance(fleet, events.data());
+    assert(fleet.is_in_state<OffState>(0));
+    assert(fleet.is_in_state<OnState>(1));
+    assert(fleet.column<Counters>()[1].entries == 1);
+    assert(fleet.column<Counters>()[1].exits == 1);
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test that entry and exit functions are called exactly when they are overridden, with
+ * both transit modes
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class NextEvent : public scriptsizefsm::Event {};
+
+enum class Mode
+{
+    classic,
+    compact,
+    thunks,
+};
+
+template<Mode M>
+class FSM;
+
+// the generic state overrides the entry function, only one state overrides the exit function
+template<Mode M>
+class GenericState : public scriptsizefsm::State<FSM<M>> {
+  public:
+
+    virtual void entry(FSM<M>* const fsm) const override;
+    virtual void react(FSM<M>* const fsm, const NextEvent& event) const {};
+};
+
+template<Mode M>
+class ExitState : public GenericState<M> {
+  public:
+
+    void exit(FSM<M>* const fsm) const override;
+    void react(FSM<M>* const fsm, const NextEvent& event) const override;
+};
+
+template<Mode M>
+class PlainState : public GenericState<M> {
+  public:
+
+    void react(FSM<M>* const fsm, const NextEvent& event) const override;
+};
+
+template<Mode M>
+using States = scriptsizefsm::StateList<ExitState<M>, PlainState<M>>;
+
+template<Mode M>
+using FSMBase = std::conditional_t<
+    M != Mode::classic,
+    scriptsizefsm::CompactFSM<
+        FSM<M>,
+        GenericState<M>,
+        States<M>,
+        ExitState<M>>,
+    scriptsizefsm::FSM<FSM<M>, GenericState<M>>>;
+
+template<Mode M>
+class FSM : public FSMBase<M> {
+    friend FSMBase<M>;
+
+  public:
+
+    static constexpr scriptsizefsm::TransitMode transit_mode =
+        M == Mode::thunks ? scriptsizefsm::TransitMode::thunks
+                          : scriptsizefsm::TransitMode::dispatch;
+
+    std::string log {};
+
+  protected:
+
+    template<typename... T_Arg>
+    FSM(T_Arg... args)
+      : FSMBase<M>(args...) {}
+};
+
+template<Mode M>
+void GenericState<M>::entry(FSM<M>* const fsm) const
+{
+    fsm->log += "entry ";
+};
+
+template<Mode M>
+void ExitState<M>::exit(FSM<M>* const fsm) const
+{
+    fsm->log += "exit ";
+};
+
+template<Mode M>
+void ExitState<M>::react(FSM<M>* const fsm, const NextEvent& event) const
+{
+    this->template transit<PlainState<M>>(fsm);
+};
+
+template<Mode M>
+void PlainState<M>::react(FSM<M>* const fsm, const NextEvent& event) const
+{
+    this->template transit<ExitState<M>>(fsm);
+};
+
+static_assert(scriptsizefsm::_overrides_entry<PlainState<Mode::classic>, FSM<Mode::classic>>());
+static_assert(!scriptsizefsm::_overrides_exit<PlainState<Mode::classic>, FSM<Mode::classic>>());
+static_assert(scriptsizefsm::_overrides_exit<ExitState<Mode::classic>, FSM<Mode::classic>>());
+static_assert(!scriptsizefsm::_any_overrides_exit<FSM<Mode::classic>>(
+    scriptsizefsm::StateList<PlainState<Mode::classic>> {}
+));
+
+template<Mode M>
+void test()
+{
+    auto fsm = scriptsizefsm::start<FSM<M>, ExitState<M>>();
+    fsm.react(NextEvent());
+    fsm.react(NextEvent());
+    fsm.reset();
+    assert(fsm.log == "exit entry entry exit entry ");
+}
+
+int main()
+{
+    test<Mode::classic>();
+    test<Mode::compact>();
+    test<Mode::thunks>();
+
+    return 0;
+}
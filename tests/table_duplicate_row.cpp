@@ -0,0 +1,39 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief compile-time test rejecting two rows of a transition table for the same state and event
+ *
+ * This file is only compiled. It compiles as is and has to fail to compile with `DUPLICATE_ROW`
+ * defined, which adds a second row for `OnState` and `OffEvent`.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "scriptsizefsm/table.hpp"
+
+class OnEvent : public scriptsizefsm::Event {};
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class OnState : public scriptsizefsm::State<FSM> {};
+class OffState : public scriptsizefsm::State<FSM> {};
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+using Events = scriptsizefsm::EventList<OnEvent, OffEvent>;
+using Table = scriptsizefsm::TransitionTable<
+    scriptsizefsm::Row<OnState, OffEvent, OffState>,
+#ifdef DUPLICATE_ROW
+    scriptsizefsm::Row<OnState, OffEvent, OnState>,
+#endif
+    scriptsizefsm::Row<OffState, OnEvent, OnState>>;
+
+class FSM : public scriptsizefsm::TableFSM<FSM, States, Events, Table> {
+    friend scriptsizefsm::TableFSM<FSM, States, Events, Table>;
+};
+
+void react_off(FSM& fsm)
+{
+    fsm.react(OffEvent());
+}
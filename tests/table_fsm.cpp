@@ -0,0 +1,129 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the transition table front end scriptsizefsm::TableFSM
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+
+#include "scriptsizefsm/table.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {
+  public:
+
+    OnEvent(double _current)
+      : current(_current) {};
+    double current;
+};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class OnState : public scriptsizefsm::State<FSM> {};
+
+class OffState : public scriptsizefsm::State<FSM> {
+  public:
+
+    void entry(FSM* const fsm) const override;
+};
+
+void set_current(FSM* const fsm, const OnEvent& event);
+
+using States = scriptsizefsm::StateList<OnState, OffState>;
+using Events = scriptsizefsm::EventList<OnEvent, OffEvent>;
+using Table = scriptsizefsm::TransitionTable<
+    scriptsizefsm::Row<OnState, OnEvent, void, &set_current>,
+    scriptsizefsm::Row<OnState, OffEvent, OffState>,
+    scriptsizefsm::Row<OffState, OnEvent, OnState, &set_current>>;
+
+class FSM : public scriptsizefsm::TableFSM<FSM, States, Events, Table> {
+    friend scriptsizefsm::TableFSM<FSM, States, Events, Table>;
+
+  public:
+
+    inline double getCurrent()
+    {
+        return current_;
+    };
+    inline void setCurrent(double current)
+    {
+        current_ = current;
+    };
+
+  protected:
+
+    FSM(const scriptsizefsm::State<FSM>* const init_state, double current)
+      : scriptsizefsm::TableFSM<FSM, States, Events, Table>(init_state),
+        initial_current_(current),
+        current_(current) {};
+    void resetter()
+    {
+        setCurrent(initial_current_);
+    };
+
+  private:
+
+    double initial_current_;
+    double current_;
+};
+
+void OffState::entry(FSM* const fsm) const
+{
+    fsm->setCurrent(0.);
+};
+
+void set_current(FSM* const fsm, const OnEvent& event)
+{
+    fsm->setCurrent(event.current);
+}
+
+// the table is available at compile time
+static_assert(FSM::table()[0][1].target == 1);
+static_assert(FSM::table()[1][1].target == 1);
+static_assert(FSM::table()[1][1].transition == nullptr);
+
+int main()
+{
+    constexpr double init_current {10.};
+    constexpr double some_current {20.};
+
+    // Init -> OnState + init_current
+    auto fsm = scriptsizefsm::start<FSM, OnState>(init_current);
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == init_current);
+
+    // OnState + OffEvent -> OffState + zero
+    fsm.react(OffEvent());
+    assert(fsm.is_in_state<OffState>());
+    assert(fsm.getCurrent() == 0.);
+
+    // OffState + OffEvent -> OffState, not in table
+    fsm.react(OffEvent());
+    assert(fsm.is_in_state<OffState>());
+
+    // OffState + OnEvent -> OnState + some_current
+    fsm.react(OnEvent(some_current));
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == some_current);
+
+    // OnState + OnEvent -> OnState + init_current, internal transition
+    fsm.react(OnEvent(init_current));
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == init_current);
+
+    // OnState + reset -> OnState + init_current
+    fsm.react(OffEvent());
+    fsm.reset();
+    assert(fsm.is_in_state<OnState>());
+    assert(fsm.getCurrent() == init_current);
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for state timeouts with scriptsizefsm::TimerWheel
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "scriptsizefsm/timer.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class ConnectEvent : public scriptsizefsm::Event {};
+
+class AckEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const ConnectEvent& event) const {};
+    virtual void react(FSM* const fsm, const AckEvent& event) const {};
+    virtual void react(FSM* const fsm, const scriptsizefsm::Timeout& event) const {};
+};
+
+class IdleState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const ConnectEvent& event) const override;
+};
+
+class ConnectingState : public scriptsizefsm::TimeoutState<GenericState, 100> {
+  public:
+
+    void react(FSM* const fsm, const AckEvent& event) const override;
+    void react(FSM* const fsm, const scriptsizefsm::Timeout& event) const override;
+};
+
+class ConnectedState : public GenericState {};
+
+class FSM
+  : public scriptsizefsm::FSM<FSM, GenericState>,
+    public scriptsizefsm::Timed<FSM> {
+    friend scriptsizefsm::FSM<FSM, GenericState>;
+
+  public:
+
+    int timeouts {0};
+
+  protected:
+
+    FSM(const GenericState* const init_state, scriptsizefsm::TimerWheel* wheel)
+      : scriptsizefsm::FSM<FSM, GenericState>(init_state),
+        scriptsizefsm::Timed<FSM>(*wheel) {};
+};
+
+void IdleState::react(FSM* const fsm, const ConnectEvent& event) const
+{
+    transit<ConnectingState>(fsm);
+};
+
+void ConnectingState::react(FSM* const fsm, const AckEvent& event) const
+{
+    transit<ConnectedState>(fsm);
+};
+
+void ConnectingState::react(FSM* const fsm, const scriptsizefsm::Timeout& event) const
+{
+    ++fsm->timeouts;
+    transit<IdleState>(fsm);
+};
+
+class Counter : public scriptsizefsm::Timer {
+  public:
+
+    static void expire(scriptsizefsm::Timer& timer)
+    {
+        auto& counter = static_cast<Counter&>(timer);
+        ++counter.fired;
+        counter.fired_at = counter.wheel()->now();
+    }
+
+    int fired {0};
+    std::uint64_t fired_at {0};
+};
+
+// the timer of a FSM takes four words, shared state lives in the wheel
+static_assert(sizeof(scriptsizefsm::Timed<FSM>) == 3 * sizeof(void*) + sizeof(std::uint64_t));
+
+int main()
+{
+    scriptsizefsm::TimerWheel wheel {&FSM::expire};
+
+    // entering the state arms the timeout, it expires after 100 ticks
+    auto fsm = scriptsizefsm::start<FSM, IdleState>(&wheel);
+    fsm.react(ConnectEvent());
+    assert(fsm.is_in_state<ConnectingState>());
+    assert(fsm.timeout_armed());
+    assert(wheel.size() == 1);
+    assert(wheel.advance(99) == 0);
+    assert(fsm.is_in_state<ConnectingState>());
+    assert(wheel.advance(100) == 1);
+    assert(fsm.is_in_state<IdleState>());
+    assert(fsm.timeouts == 1);
+    assert(!fsm.timeout_armed());
+
+    // exiting the state before cancels the timeout
+    fsm.react(ConnectEvent());
+    wheel.advance(150);
+    fsm.react(AckEvent());
+    assert(fsm.is_in_state<ConnectedState>());
+    assert(!fsm.timeout_armed());
+    assert(wheel.size() == 0);
+    assert(wheel.advance(1000) == 0);
+    assert(fsm.timeouts == 1);
+
+    // moving a FSM relinks its armed timeout, which then reaches the moved-to FSM
+    fsm.reset();
+    fsm.react(ConnectEvent());
+    auto moved = std::move(fsm);
+    assert(moved.timeout_armed() && !fsm.timeout_armed());
+    assert(wheel.size() == 1);
+    assert(wheel.advance(wheel.now() + 100) == 1);
+    assert(moved.is_in_state<IdleState>());
+    assert(moved.timeouts == 2);
+    assert(fsm.timeouts == 1);
+
+    // the timers of other objects are kept on a wheel of their own, with their own callback
+    scriptsizefsm::TimerWheel timers {&Counter::expire};
+
+    // timers at all levels of the wheel fire exactly at their deadline
+    std::mt19937_64 generator {42};
+    std::vector<std::unique_ptr<Counter>> counters {};
+    std::vector<std::uint64_t> deadlines {};
+    for(std::uint64_t delay : {1ULL, 63ULL, 64ULL, 65ULL, 4095ULL, 4096ULL, 300000ULL}) {
+        counters.emplace_back(new Counter());
+        timers.arm(*counters.back(), delay);
+        deadlines.push_back(timers.now() + delay);
+    }
+    for(int timer = 0; timer < 1000; ++timer) {
+        const std::uint64_t delay = 1 + generator() % 100000;
+        counters.emplace_back(new Counter());
+        timers.arm(*counters.back(), delay);
+        deadlines.push_back(timers.now() + delay);
+    }
+
+    // every other timer is cancelled
+    for(std::size_t index = 7; index < counters.size(); index += 2) {
+        counters[index]->cancel();
+    }
+    assert(timers.size() == 7 + 500);
+
+    // advanced in uneven steps
+    std::size_t fired = 0;
+    for(std::uint64_t now = timers.now(); now < 1000 + 300000; now += 1 + generator() % 500) {
+        fired += timers.advance(now);
+    }
+    fired += timers.advance(1000 + 300000);
+    assert(fired == 7 + 500);
+    assert(timers.size() == 0);
+    for(std::size_t index = 0; index < counters.size(); ++index) {
+        const bool cancelled = index >= 7 && (index - 7) % 2 == 0;
+        assert(counters[index]->fired == (cancelled ? 0 : 1));
+        assert(cancelled || counters[index]->fired_at == deadlines[index]);
+    }
+
+    // re-arming moves the deadline
+    Counter counter {};
+    timers.arm(counter, 10);
+    timers.arm(counter, 20);
+    assert(timers.size() == 1);
+    assert(timers.advance(timers.now() + 10) == 0);
+    assert(timers.advance(timers.now() + 10) == 1);
+    assert(counter.fired == 1);
+
+    // a moved timer takes the place of the original among the other timers of its slot
+    Counter first {};
+    Counter second {};
+    Counter third {};
+    for(Counter* const armed : {&first, &second, &third}) {
+        timers.arm(*armed, 5);
+    }
+    Counter relocated {std::move(second)};
+    assert(relocated.armed() && !second.armed());
+    assert(timers.advance(timers.now() + 5) == 3);
+    assert(first.fired == 1 && relocated.fired == 1 && third.fired == 1 && second.fired == 0);
+
+    // idle spans are skipped instead of stepped through, even when far larger than the wheel
+    const auto started = std::chrono::steady_clock::now();
+    const std::uint64_t far = timers.now() + (1ULL << 40U) + 12345;
+    timers.arm(counter, far - timers.now());
+    assert(timers.advance(far - 1) == 0);
+    assert(timers.now() == far - 1);
+    assert(timers.advance(far + (1ULL << 50U)) == 1);
+    assert(counter.fired == 2);
+    assert(counter.fired_at == far);
+    timers.arm(counter, (1ULL << 50U) + 7);
+    assert(timers.advance(timers.now() + (1ULL << 50U) + 7) == 1);
+    assert(counter.fired == 3);
+    assert(std::chrono::steady_clock::now() - started < std::chrono::milliseconds(100));
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief test for the tracing policy of the FSMs
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+#ifdef NDEBUG
+#error "Compiling with NDEBUG defeats the purpose of this test"
+#endif
+
+class OnEvent : public scriptsizefsm::Event {};
+
+class OffEvent : public scriptsizefsm::Event {};
+
+inline std::string event_name(const OnEvent& event)
+{
+    return "on";
+}
+
+inline std::string event_name(const OffEvent& event)
+{
+    return "off";
+}
+
+class Tracer {
+  public:
+
+    template<class T_FSM, class T_State_Id, class T_Event>
+    void on_react(const T_FSM& fsm, T_State_Id state, const T_Event& event)
+    {
+        log += "react(" + std::to_string(state) + "," + event_name(event) + ") ";
+    }
+
+    template<class T_FSM, class T_State_Id, class T_Event>
+    void on_unhandled(const T_FSM& fsm, T_State_Id state, const T_Event& event)
+    {
+        log += "unhandled(" + std::to_string(state) + "," + event_name(event) + ") ";
+    }
+
+    template<class T_FSM, class T_State_Id>
+    void on_transit(const T_FSM& fsm, T_State_Id from, T_State_Id to)
+    {
+        log += "transit(" + std::to_string(from) + "," + std::to_string(to) + ") ";
+    }
+
+    template<class T_FSM>
+    void on_reset(const T_FSM& fsm)
+    {
+        log += "reset ";
+    }
+
+    std::string log {};
+};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const OnEvent& event) const {};
+    virtual void react(FSM* const fsm, const OffEvent& event) const {};
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override;
+};
+
+// intermediate base class with a reaction, which the state re-exposes next to its own overload
+class Latching : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const OnEvent& event) const override {};
+};
+
+class LatchedState : public Latching {
+  public:
+
+    using Latching::react;
+    void react(FSM* const fsm, const OffEvent& event) const override;
+};
+
+using States = scriptsizefsm::StateList<OnState, OffState, LatchedState>;
+
+class FSM : public scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer> {
+    friend scriptsizefsm::CompactFSM<FSM, GenericState, States, OnState, Tracer>;
+};
+
+void OnState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+void OffState::react(FSM* const fsm, const OnEvent& event) const
+{
+    transit<OnState>(fsm);
+};
+
+void LatchedState::react(FSM* const fsm, const OffEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+class UntracedFSM;
+
+class UntracedState : public scriptsizefsm::State<UntracedFSM> {};
+
+using UntracedStates = scriptsizefsm::StateList<UntracedState>;
+
+class UntracedFSM
+  : public scriptsizefsm::CompactFSM<UntracedFSM, UntracedState, UntracedStates, UntracedState> {
+    friend scriptsizefsm::CompactFSM<UntracedFSM, UntracedState, UntracedStates, UntracedState>;
+};
+
+// the default policy adds no storage and keeps the FSM trivially copyable
+static_assert(std::is_empty_v<scriptsizefsm::NoTracer>);
+static_assert(sizeof(UntracedFSM) == 1);
+static_assert(std::is_trivially_copyable_v<UntracedFSM>);
+
+class ClassicFSM;
+
+class ClassicGenericState : public scriptsizefsm::State<ClassicFSM> {
+  public:
+
+    virtual void react(ClassicFSM* const fsm, const OnEvent& event) const {};
+};
+
+class ClassicOffState : public ClassicGenericState {
+  public:
+
+    void react(ClassicFSM* const fsm, const OnEvent& event) const override;
+};
+
+class ClassicOnState : public ClassicGenericState {};
+
+class CountingTracer {
+  public:
+
+    template<class T_FSM, class T_State_Id, class T_Event>
+    void on_react(const T_FSM& fsm, T_State_Id state, const T_Event& event)
+    {
+        ++reactions;
+    }
+
+    template<class T_FSM, class T_State_Id>
+    void on_transit(const T_FSM& fsm, T_State_Id from, T_State_Id to)
+    {
+        ++transitions;
+        last_from = from;
+        last_to = to;
+    }
+
+    template<class T_FSM>
+    void on_reset(const T_FSM& fsm)
+    {
+        ++resets;
+    }
+
+    int reactions {0};
+    int transitions {0};
+    int resets {0};
+    const ClassicGenericState* last_from {nullptr};
+    const ClassicGenericState* last_to {nullptr};
+};
+
+class ClassicFSM : public scriptsizefsm::FSM<ClassicFSM, ClassicGenericState, CountingTracer> {
+    friend scriptsizefsm::FSM<ClassicFSM, ClassicGenericState, CountingTracer>;
+
+  protected:
+
+    ClassicFSM(const ClassicGenericState* const init_state)
+      : scriptsizefsm::FSM<ClassicFSM, ClassicGenericState, CountingTracer>(init_state) {};
+};
+
+void ClassicOffState::react(ClassicFSM* const fsm, const OnEvent& event) const
+{
+    transit<ClassicOnState>(fsm);
+};
+
+int main()
+{
+    // the tracer sees reactions, events falling through to the generic state and transitions
+    auto fsm = scriptsizefsm::start<FSM, OnState>();
+    fsm.react(OnEvent());
+    fsm.react(OffEvent());
+    assert(fsm.is_in_state<OffState>());
+    fsm._react_in<OffState>(OnEvent());
+    assert(fsm.is_in_state<OnState>());
+    fsm.reset();
+    assert(
+        fsm.tracer().log ==
+        "react(0,on) unhandled(0,on) react(0,off) transit(0,1) react(1,on) transit(1,0) reset "
+    );
+
+    // a reaction inherited from an intermediate base class is handled, even if the state hides it
+    fsm.tracer().log.clear();
+    fsm._react_in<LatchedState>(OnEvent());
+    assert(fsm.tracer().log == "react(2,on) ");
+
+    // the classic FSM identifies states by their instance
+    auto classic = scriptsizefsm::start<ClassicFSM, ClassicOffState>();
+    classic.react(OnEvent());
+    classic.react(OnEvent());
+    assert(classic.is_in_state<ClassicOnState>());
+    classic.reset();
+    assert(classic.tracer().reactions == 2);
+    assert(classic.tracer().transitions == 1);
+    assert(classic.tracer().resets == 1);
+    assert(classic.tracer().last_from != classic.tracer().last_to);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief code of a FSM with the default tracing policy and of the same FSM without tracing
+ *
+ * This file is only compiled to assembly. `tracer_codegen_check` then compares `traced_step`, a
+ * reaction of a `CompactFSM` with `NoTracer`, with `untraced_step`, the same reaction written by
+ * hand, which have to compile to the same instructions.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "scriptsizefsm/scriptsizefsm.hpp"
+
+class StepEvent : public scriptsizefsm::Event {};
+
+class FSM;
+
+class GenericState : public scriptsizefsm::State<FSM> {
+  public:
+
+    virtual void react(FSM* const fsm, const StepEvent& event) const {};
+};
+
+class OffState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const StepEvent& event) const override;
+};
+
+class OnState : public GenericState {
+  public:
+
+    void react(FSM* const fsm, const StepEvent& event) const override;
+};
+
+class IdleState : public GenericState {};
+
+using States = scriptsizefsm::StateList<OffState, OnState, IdleState>;
+
+using FSMBase =
+    scriptsizefsm::CompactFSM<FSM, GenericState, States, OffState, scriptsizefsm::NoTracer>;
+
+class FSM : public FSMBase {
+    friend FSMBase;
+
+  public:
+
+    /**
+     * @brief reacts to a step event, without the run-to-completion queue
+     */
+    void step()
+    {
+        react_current(StepEvent());
+    };
+
+    int steps {0};
+};
+
+void OffState::react(FSM* const fsm, const StepEvent& event) const
+{
+    ++fsm->steps;
+    transit<OnState>(fsm);
+};
+
+void OnState::react(FSM* const fsm, const StepEvent& event) const
+{
+    transit<OffState>(fsm);
+};
+
+/**
+ * @brief the same FSM without tracing, with the index of the current state and the data
+ */
+struct PlainFSM {
+    std::uint8_t state;
+    int steps;
+};
+
+extern "C" void traced_step(FSM& fsm)
+{
+    fsm.step();
+}
+
+extern "C" void untraced_step(PlainFSM& fsm)
+{
+    const std::size_t state = fsm.state;
+    if(state == 0) {
+        ++fsm.steps;
+        fsm.state = 1;
+    } else if(state == 1) {
+        fsm.state = 0;
+    }
+}
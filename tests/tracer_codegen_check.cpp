@@ -0,0 +1,60 @@
+/**
+ * @file
+ * \ingroup tests
+ * @brief checks that the default tracing policy compiles to the same code as no tracing
+ *
+ * Takes the assembly of tracer_codegen.cpp and compares the instructions of `traced_step` and
+ * `untraced_step`, ignoring the names of local labels.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief lines of the body of a function in an assembly file, with local labels renamed
+ */
+std::vector<std::string> function_body(const std::string& path, const std::string& function)
+{
+    static const std::regex local_label {R"(\.L[A-Z]*[0-9]+)"};
+    std::ifstream file {path};
+    std::vector<std::string> body {};
+    bool inside = false;
+    for(std::string line; std::getline(file, line);) {
+        if(!inside) {
+            inside = line == function + ":";
+            continue;
+        }
+        if(line.find(".cfi_endproc") != std::string::npos) {
+            break;
+        }
+        body.push_back(std::regex_replace(line, local_label, ".L"));
+    }
+    return body;
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc != 2) {
+        std::cerr << "usage: " << argv[0] << " tracer_codegen.s" << std::endl;
+        return 2;
+    }
+
+    const auto traced = function_body(argv[1], "traced_step");
+    const auto untraced = function_body(argv[1], "untraced_step");
+    if(traced.empty() || untraced.empty()) {
+        std::cerr << "functions not found in " << argv[1] << std::endl;
+        return 1;
+    }
+    if(traced != untraced) {
+        std::cerr << "NoTracer changes the generated code" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file
+ * \ingroup tools
+ * @brief prints a dump of scriptsizefsm::FlightRecorder with the names of states and events
+ *
+ * Usage: `trace_decode <dump>`. Each line contains the time since the oldest record in
+ * timestamp ticks, the instance id and what happened, oldest record first.
+ *
+ * @copyright Copyright © 2022 Stephan Lachnit <stephanlachnit@debian.org>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+#include "scriptsizefsm/recorder.hpp"
+
+using scriptsizefsm::FlightRecorder;
+
+/**
+ * @brief readable name of a type from its `typeid` name
+ */
+std::string demangle(const std::string& name)
+{
+#if __has_include(<cxxabi.h>)
+    int status = 0;
+    std::unique_ptr<char, void (*)(void*)> demangled {
+        abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status), &std::free};
+    if(status == 0 && demangled != nullptr) {
+        return demangled.get();
+    }
+#endif
+    return name;
+}
+
+/**
+ * @brief name of the state or event with a given index, or the index if it is out of range
+ */
+std::string lookup(
+    const std::vector<std::string>& names,
+    std::size_t offset,
+    std::size_t size,
+    std::uint16_t index
+)
+{
+    if(index == FlightRecorder::no_event) {
+        return "unlisted event";
+    }
+    return index < size ? names[offset + index] : "#" + std::to_string(index);
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <dump>" << std::endl;
+        return 2;
+    }
+    std::ifstream file {argv[1], std::ios::binary};
+    FlightRecorder::Header header {};
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+       header.magic != FlightRecorder::magic) {
+        std::cerr << argv[1] << ": not a flight recorder dump" << std::endl;
+        return 1;
+    }
+    if(header.record_size != sizeof(FlightRecorder::Record)) {
+        std::cerr << argv[1] << ": written with an incompatible record format" << std::endl;
+        return 1;
+    }
+
+    std::string packed_names(header.names_size, '\0');
+    std::vector<FlightRecorder::Record> records(header.capacity);
+    const auto records_size =
+        static_cast<std::streamsize>(records.size() * sizeof(FlightRecorder::Record));
+    if(!file.read(packed_names.data(), static_cast<std::streamsize>(packed_names.size())) ||
+       !file.read(reinterpret_cast<char*>(records.data()), records_size)) {
+        std::cerr << argv[1] << ": truncated" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> names {};
+    for(std::size_t begin = 0; begin < packed_names.size();) {
+        const std::size_t end = packed_names.find('\0', begin);
+        names.push_back(demangle(packed_names.substr(begin, end - begin)));
+        begin = end + 1;
+    }
+    if(names.size() != std::size_t {header.n_states} + header.n_events) {
+        std::cerr << argv[1] << ": corrupt name table" << std::endl;
+        return 1;
+    }
+
+    const std::uint64_t end = header.written;
+    const std::uint64_t begin = end > header.capacity ? end - header.capacity : 0;
+    std::uint64_t torn = 0;
+    std::uint64_t start = 0;
+    for(std::uint64_t index = end; index > begin; --index) {
+        const auto& record = records[(index - 1) % header.capacity];
+        if(record.torn != 0) {
+            ++torn;
+        } else {
+            start = record.timestamp;
+        }
+    }
+    std::cout << end << " records written, " << end - begin << " kept";
+    if(torn > 0) {
+        std::cout << ", " << torn << " torn while dumping";
+    }
+    std::cout << std::endl;
+    for(std::uint64_t index = begin; index < end; ++index) {
+        const auto& record = records[index % header.capacity];
+        if(record.torn != 0) {
+            continue;
+        }
+        const auto state = [&](std::uint16_t id) {
+            return lookup(names, 0, header.n_states, id);
+        };
+        const auto event = [&](std::uint16_t id) {
+            return lookup(names, header.n_states, header.n_events, id);
+        };
+        std::cout << "+" << record.timestamp - start << " #" << record.instance << " ";
+        switch(record.kind) {
+        case FlightRecorder::Kind::react:
+            std::cout << state(record.from) << " reacts to " << event(record.event);
+            break;
+        case FlightRecorder::Kind::transit:
+            std::cout << state(record.from) << " -> " << state(record.to);
+            if(record.event != FlightRecorder::no_event) {
+                std::cout << " on " << event(record.event);
+            }
+            break;
+        case FlightRecorder::Kind::reset:
+            std::cout << state(record.from) << " reset";
+            break;
+        default:
+            std::cout << "unknown record";
+            break;
+        }
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+
+    return 0;
+}